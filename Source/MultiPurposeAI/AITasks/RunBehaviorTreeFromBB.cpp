@@ -1,29 +1,59 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "RunBehaviorTreeFromBB.h"
+#include "MultiPurposeAI.h"
+#include "Diagnostics/AIDiagnostics.h"
+#include "Diagnostics/AIStats.h"
 #include "AIController.h"
 #include "BehaviorTree/BlackboardComponent.h"
 #include "BehaviorTree/BehaviorTree.h"
+#include "BehaviorTree/BlackboardData.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
 
 URunBehaviorTreeFromBB::URunBehaviorTreeFromBB()
 {
 	NodeName = "Run Behavior Tree from Blackboard";
+
+    BehaviorTreeKey.AddObjectFilter(this, GET_MEMBER_NAME_CHECKED(URunBehaviorTreeFromBB, BehaviorTreeKey), UBehaviorTree::StaticClass());
+}
+
+void URunBehaviorTreeFromBB::InitializeFromAsset(UBehaviorTree& Asset)
+{
+    Super::InitializeFromAsset(Asset);
+
+    if (UBlackboardData* BBAsset = GetBlackboardAsset())
+    {
+        BehaviorTreeKey.ResolveSelectedKey(*BBAsset);
+    }
+}
+
+FString URunBehaviorTreeFromBB::GetStaticDescription() const
+{
+    if (bInjectAsDynamicSubtree)
+    {
+        return FString::Printf(TEXT("Inject %s into %s"), *BehaviorTreeKey.SelectedKeyName.ToString(), *InjectionTag.ToString());
+    }
+
+    return FString::Printf(TEXT("Run %s"), *BehaviorTreeKey.SelectedKeyName.ToString());
 }
 
 EBTNodeResult::Type URunBehaviorTreeFromBB::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
-{// Get the Blackboard component
+{
+    MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_RunBehaviorTreeFromBB);
+
+    // Get the Blackboard component
     UBlackboardComponent* BlackboardComp = OwnerComp.GetBlackboardComponent();
     if (!BlackboardComp)
     {
-        UE_LOG(LogTemp, Error, TEXT("Blackboard component not found"));
+        UE_LOG(LogMultiPurposeAI, Error, TEXT("Blackboard component not found"));
         return EBTNodeResult::Failed;
     }
 
     // Retrieve the Behavior Tree object from the Blackboard
-    UObject* BehaviorTreeObj = BlackboardComp->GetValueAsObject(BehaviorTreeKey.SelectedKeyName);
+    UObject* BehaviorTreeObj = BlackboardComp->GetValue<UBlackboardKeyType_Object>(BehaviorTreeKey.GetSelectedKeyID());
     if (!BehaviorTreeObj)
     {
-        UE_LOG(LogTemp, Error, TEXT("Behavior Tree object not found in Blackboard"));
+        UE_LOG(LogMultiPurposeAI, Error, TEXT("Behavior Tree object not found in Blackboard"));
         return EBTNodeResult::Failed;
     }
 
@@ -31,7 +61,7 @@ EBTNodeResult::Type URunBehaviorTreeFromBB::ExecuteTask(UBehaviorTreeComponent&
     UBehaviorTree* BehaviorTree = Cast<UBehaviorTree>(BehaviorTreeObj);
     if (!BehaviorTree)
     {
-        UE_LOG(LogTemp, Error, TEXT("Failed to cast Blackboard value to UBehaviorTree"));
+        UE_LOG(LogMultiPurposeAI, Error, TEXT("Failed to cast Blackboard value to UBehaviorTree"));
         return EBTNodeResult::Failed;
     }
 
@@ -39,13 +69,25 @@ EBTNodeResult::Type URunBehaviorTreeFromBB::ExecuteTask(UBehaviorTreeComponent&
     AAIController* AIController = OwnerComp.GetAIOwner();
     if (!AIController)
     {
-        UE_LOG(LogTemp, Error, TEXT("AIController not found"));
+        UE_LOG(LogMultiPurposeAI, Error, TEXT("AIController not found"));
         return EBTNodeResult::Failed;
     }
 
+    if (bInjectAsDynamicSubtree)
+    {
+        // Always injected, another node or game code may have swapped the subtree under the same tag since.
+        // Node templates of the subtree are cached by the behavior tree manager, only the parent's dynamic node is swapped
+        OwnerComp.SetDynamicSubtree(InjectionTag, BehaviorTree);
+        MPAI_COUNT(SubtreesInjected);
+        UE_LOG(LogMultiPurposeAI, Verbose, TEXT("Injected Behavior Tree: %s"), *BehaviorTree->GetName());
+
+        return EBTNodeResult::Succeeded;
+    }
+
     // Run the Behavior Tree
     AIController->RunBehaviorTree(BehaviorTree);
-    UE_LOG(LogTemp, Log, TEXT("Successfully ran Behavior Tree: %s"), *BehaviorTree->GetName());
+    MPAI_COUNT(SubtreesRun);
+    UE_LOG(LogMultiPurposeAI, Verbose, TEXT("Successfully ran Behavior Tree: %s"), *BehaviorTree->GetName());
 
     // Indicate success
     return EBTNodeResult::Succeeded;
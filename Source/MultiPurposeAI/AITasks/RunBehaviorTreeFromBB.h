@@ -3,9 +3,12 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
 #include "BehaviorTree/BTTaskNode.h"
 #include "RunBehaviorTreeFromBB.generated.h"
 
+class UBehaviorTree;
+
 /**
  * 
  */
@@ -23,6 +26,18 @@ protected:
     UPROPERTY(EditAnywhere, Category = "Blackboard")
     FBlackboardKeySelector BehaviorTreeKey;
 
+    /** Inject the tree into the running tree's "Run Behavior Dynamic" nodes instead of replacing the whole tree */
+    UPROPERTY(EditAnywhere, Category = "Subtree")
+    bool bInjectAsDynamicSubtree = false;
+
+    /** Tag of the "Run Behavior Dynamic" nodes receiving the subtree */
+    UPROPERTY(EditAnywhere, Category = "Subtree", meta = (EditCondition = "bInjectAsDynamicSubtree"))
+    FGameplayTag InjectionTag;
+
+    virtual void InitializeFromAsset(UBehaviorTree& Asset) override;
+
     /** Executes the task */
     virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+    virtual FString GetStaticDescription() const override;
 };
@@ -3,5 +3,7 @@
 #include "MultiPurposeAI.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogMultiPurposeAI);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, MultiPurposeAI, "MultiPurposeAI" );
- 
\ No newline at end of file
+ 
@@ -2,4 +2,11 @@
 
 #pragma once
 
-#include "CoreMinimal.h"
\ No newline at end of file
+#include "CoreMinimal.h"
+
+// Shipping builds compile out everything below Warning, so hot path Verbose/Log lines cost nothing there
+#if UE_BUILD_SHIPPING
+DECLARE_LOG_CATEGORY_EXTERN(LogMultiPurposeAI, Log, Warning);
+#else
+DECLARE_LOG_CATEGORY_EXTERN(LogMultiPurposeAI, Log, All);
+#endif
@@ -3,6 +3,11 @@
 
 #include "Components/DamageableComponent.h"
 #include "Kismet/GameplayStatics.h"
+#include "MultiPurposeAI.h"
+#include "Diagnostics/AIDiagnostics.h"
+#include "Diagnostics/AIStats.h"
+#include "Subsystems/DamageQueueSubsystem.h"
+#include "Engine/World.h"
 
 // Sets default values for this component's properties
 UDamageableComponent::UDamageableComponent()
@@ -19,27 +24,105 @@ UDamageableComponent::UDamageableComponent()
 void UDamageableComponent::BeginPlay()
 {
 	Super::BeginPlay();
+
+	if (CharacterMaxHealth <= 0.0f && DefaultMaxHealth > 0.0f)
+	{
+		CharacterMaxHealth = DefaultMaxHealth;
+		CharacterCurrentHealth = DefaultMaxHealth;
+	}
+
 	AActor* Owner = GetOwner();
 	if (Owner)
 	{
 		Owner->OnTakeAnyDamage.AddDynamic(this, &UDamageableComponent::TakeDamage);
 	}
+
+	if (bUseDamageQueue)
+	{
+		RegisterWithDamageQueue();
+	}
+}
+
+void UDamageableComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterFromDamageQueue();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UDamageableComponent::SetUseDamageQueue(bool bEnable)
+{
+	bUseDamageQueue = bEnable;
+
+	// Otherwise BeginPlay registers it
+	if (!HasBegunPlay())
+	{
+		return;
+	}
+
+	if (bEnable)
+	{
+		RegisterWithDamageQueue();
+	}
+	else
+	{
+		UnregisterFromDamageQueue();
+	}
+}
+
+void UDamageableComponent::RegisterWithDamageQueue()
+{
+	if (DamageQueue)
+	{
+		return;
+	}
+
+	DamageQueue = GetWorld()->GetSubsystem<UDamageQueueSubsystem>();
+	if (DamageQueue)
+	{
+		DamageHandle = DamageQueue->RegisterTarget(this, CharacterMaxHealth, CharacterCurrentHealth);
+	}
+}
+
+void UDamageableComponent::UnregisterFromDamageQueue()
+{
+	if (!DamageQueue)
+	{
+		return;
+	}
+
+	// Keep the last known health for anything still querying the component
+	CharacterCurrentHealth = DamageQueue->GetCurrentHealth(DamageHandle);
+	CharacterMaxHealth = DamageQueue->GetMaxHealth(DamageHandle);
+	DamageQueue->UnregisterTarget(DamageHandle);
+	DamageQueue = nullptr;
+	DamageHandle = INDEX_NONE;
 }
 
 float UDamageableComponent::GetCurrentHealth() const
 {
-	return CharacterCurrentHealth;
+	return DamageQueue ? DamageQueue->GetCurrentHealth(DamageHandle) : CharacterCurrentHealth;
 }
 
 float UDamageableComponent::GetMaxHealth() const
 {
-	return CharacterMaxHealth;
+	return DamageQueue ? DamageQueue->GetMaxHealth(DamageHandle) : CharacterMaxHealth;
 }
 
 void UDamageableComponent::TakeDamage(AActor* DamagedActor, float Damage, const UDamageType* DamageType,
 	AController* InstigatedBy, AActor* DamageCauser)
 {
-	if (Damage <= 0.0f)
+	MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_TakeDamage);
+
+	// Resolved with every other hit of the frame
+	if (DamageQueue)
+	{
+		DamageQueue->QueueDamage(DamageHandle, Damage);
+		return;
+	}
+
+	// Dead characters waiting in a pool must not die a second time
+	if (Damage <= 0.0f || CharacterCurrentHealth <= 0.0f)
 		return;
 	float Health;
 
@@ -47,24 +130,48 @@ void UDamageableComponent::TakeDamage(AActor* DamagedActor, float Damage, const
 
 	SetCurrentHealth(Health);
 
-	UE_LOG(LogTemp, Warning, TEXT("%s's DamageableComponent took %f damage. Remaining health: %f"),
-		*GetOwner()->GetName(), Damage, Health);
+	MPAI_COUNT(DamageEvents);
+	UE_LOG(LogMultiPurposeAI, VeryVerbose, TEXT("%s took %f damage. Remaining health: %f"),
+		*GetNameSafe(GetOwner()), Damage, Health);
 
 	if (CharacterCurrentHealth <= 0.0f)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("%s died!"), *GetOwner()->GetName());
+		HandleDeath();
+	}
+}
+
+void UDamageableComponent::HandleDeath()
+{
+	MPAI_COUNT(Deaths);
+	UE_LOG(LogMultiPurposeAI, Verbose, TEXT("%s died"), *GetNameSafe(GetOwner()));
+
+	if (OnDeath.IsBound())
+	{
 		OnDeath.Broadcast(GetOwner());
+	}
+	if (bDestroyOwnerOnDeath)
+	{
 		GetOwner()->Destroy();
 	}
 }
 
 void UDamageableComponent::SetMaxHealth(float MaxHealth)
 {
+	if (DamageQueue)
+	{
+		DamageQueue->SetMaxHealth(DamageHandle, MaxHealth);
+		return;
+	}
 	CharacterMaxHealth = MaxHealth;
 }
 
 void UDamageableComponent::SetCurrentHealth(float Health)
 {
+	if (DamageQueue)
+	{
+		DamageQueue->SetCurrentHealth(DamageHandle, Health);
+		return;
+	}
 	CharacterCurrentHealth = Health;
 }
 
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/ProfiledBehaviorTreeComponent.h"
+#include "Diagnostics/AIBehaviorTreeProfiler.h"
+#include "Data/CharacterDataAsset.h"
+#include "AIController.h"
+#include "BehaviorTree/BTTaskNode.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Enum.h"
+#include "Engine/World.h"
+#include "HAL/PlatformTime.h"
+
+void UProfiledBehaviorTreeComponent::InstallOn(AAIController* Controller, const UCharacterDataAsset* DataAsset)
+{
+    if (!Controller)
+    {
+        return;
+    }
+
+    UProfiledBehaviorTreeComponent* Profiled = Cast<UProfiledBehaviorTreeComponent>(Controller->GetBrainComponent());
+    if (!Profiled)
+    {
+        // Controllers that already have a brain, e.g. pooled before profiling was turned on, keep it
+        if (Controller->GetBrainComponent())
+        {
+            return;
+        }
+
+        // AAIController::RunBehaviorTree reuses whatever behavior tree component is already its brain
+        Profiled = NewObject<UProfiledBehaviorTreeComponent>(Controller, TEXT("BTComponent"));
+        Profiled->RegisterComponent();
+        Controller->BrainComponent = Profiled;
+    }
+
+    Profiled->ProfiledArchetype = DataAsset;
+}
+
+void UProfiledBehaviorTreeComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+    if (!FAIBehaviorTreeProfiler::IsEnabled())
+    {
+        LastProfiledTime = -1.0;
+        Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+        return;
+    }
+
+    // Whatever the tick does, the state it started in asked for it
+    const EAICharacterState State = GetProfiledState();
+
+    // Execution requests are processed in the tick, one arriving while a task still runs aborts that task
+    const bool bHasExecutionRequest = bRequestedFlowUpdate;
+    const UBTTaskNode* ActiveTask = Cast<const UBTTaskNode>(GetActiveNode());
+    const bool bAbortTick = bHasExecutionRequest && ActiveTask && GetTaskStatus(ActiveTask) == EBTTaskStatus::Active;
+
+    const double StartTime = FPlatformTime::Seconds();
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+    const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+    // A processed request ends on the next task to run, unless the tree stopped. Tasks that finished within the tick
+    // are not visible from here, so the tick counts once
+    const bool bExecutionTick = bHasExecutionRequest && Cast<const UBTTaskNode>(GetActiveNode()) != nullptr;
+
+    // The tree may not tick for a while, e.g. paused by AI LOD, the agent still spent that time in the state
+    const double Now = GetWorld()->GetTimeSeconds();
+    const double AgentSeconds = LastProfiledTime >= 0.0 ? Now - LastProfiledTime : DeltaTime;
+    LastProfiledTime = Now;
+
+    FAIBehaviorTreeProfiler::Record(ProfiledArchetype, State, ElapsedMs, AgentSeconds, bExecutionTick, bAbortTick);
+}
+
+EAICharacterState UProfiledBehaviorTreeComponent::GetProfiledState()
+{
+    const UBlackboardComponent* Blackboard = GetBlackboardComponent();
+    const UBlackboardData* BlackboardAsset = Blackboard ? Blackboard->GetBlackboardAsset() : nullptr;
+    if (!BlackboardAsset)
+    {
+        return EAICharacterState::None;
+    }
+
+    if (AIStateKeyBlackboard.Get() != BlackboardAsset)
+    {
+        AIStateKeyBlackboard = BlackboardAsset;
+        AIStateKey = Blackboard->GetKeyID(UCharacterDataAsset::AIStateKeyName);
+    }
+
+    if (AIStateKey == FBlackboard::InvalidKey)
+    {
+        return EAICharacterState::None;
+    }
+
+    return static_cast<EAICharacterState>(Blackboard->GetValue<UBlackboardKeyType_Enum>(AIStateKey));
+}
@@ -2,6 +2,9 @@
 
 
 #include "Components/StateManagerComponent.h"
+#include "Subsystems/AIStateSubsystem.h"
+#include "Data/CharacterDataAsset.h"
+#include "Engine/World.h"
 
 // Sets default values for this component's properties
 UStateManagerComponent::UStateManagerComponent()
@@ -11,6 +14,7 @@ UStateManagerComponent::UStateManagerComponent()
 	PrimaryComponentTick.bCanEverTick = false;
 
 	// ...
+	CurrentState = EAICharacterState::None;
 }
 
 
@@ -19,13 +23,150 @@ void UStateManagerComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// ...
-	
+	StateSubsystem = GetWorld()->GetSubsystem<UAIStateSubsystem>();
+	if (StateSubsystem)
+	{
+		StateHandle = StateSubsystem->RegisterAgent(GetOwner(), CurrentState);
+	}
+}
+
+void UStateManagerComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (StateSubsystem)
+	{
+		// Keep the last known state for anything still querying the component
+		CurrentState = StateSubsystem->GetState(StateHandle);
+		StateSubsystem->UnregisterAgent(StateHandle);
+		StateSubsystem = nullptr;
+		StateHandle = INDEX_NONE;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+EAICharacterState UStateManagerComponent::GetCurrentState() const
+{
+	return StateSubsystem ? StateSubsystem->GetState(StateHandle) : CurrentState;
+}
+
+EAICharacterState UStateManagerComponent::GetPreviousState() const
+{
+	return StateSubsystem ? StateSubsystem->GetPreviousState(StateHandle) : EAICharacterState::None;
+}
+
+float UStateManagerComponent::GetTimeInState() const
+{
+	return StateSubsystem ? StateSubsystem->GetTimeInState(StateHandle) : 0.0f;
 }
 
 void UStateManagerComponent::SetCurrentState(EAICharacterState NewState)
 {
-	CurrentState = NewState;
+	const EAICharacterState PreviousState = GetCurrentState();
+
+	if (StateSubsystem)
+	{
+		if (!StateSubsystem->SetState(StateHandle, NewState))
+		{
+			return;
+		}
+	}
+	else
+	{
+		if (CurrentState == NewState)
+		{
+			return;
+		}
+		CurrentState = NewState;
+	}
+
+	OnStateChanged.Broadcast(this, PreviousState, NewState);
 }
 
+bool UStateManagerComponent::RequestStateChange(EAICharacterState NewState)
+{
+	const EAICharacterState PreviousState = GetCurrentState();
+	if (PreviousState == NewState)
+	{
+		return false;
+	}
+
+	// Without a table every change is allowed
+	if (TransitionTable && TransitionTable->StateTransitions.Num() > 0)
+	{
+		const int32 RuleIndex = FindAllowedRule(PreviousState, NewState);
+		if (RuleIndex == INDEX_NONE)
+		{
+			return false;
+		}
 
+		RuleLastUsedTimes[RuleIndex] = GetWorldTime();
+	}
+
+	SetCurrentState(NewState);
+	return true;
+}
+
+void UStateManagerComponent::SetTransitionTable(UCharacterDataAsset* DataAsset)
+{
+	TransitionTable = DataAsset;
+
+	// Never used, so no cooldown is running
+	RuleLastUsedTimes.Init(-UE_BIG_NUMBER, DataAsset ? DataAsset->StateTransitions.Num() : 0);
+}
+
+int32 UStateManagerComponent::FindAllowedRule(EAICharacterState FromState, EAICharacterState ToState) const
+{
+	const TArray<FAIStateTransitionRule>& Rules = TransitionTable->StateTransitions;
+	const double Now = GetWorldTime();
+	const float TimeInState = GetTimeInState();
+
+	for (int32 RuleIndex = 0; RuleIndex < Rules.Num(); ++RuleIndex)
+	{
+		const FAIStateTransitionRule& Rule = Rules[RuleIndex];
+		if (Rule.ToState != ToState || (Rule.FromState != EAICharacterState::None && Rule.FromState != FromState))
+		{
+			continue;
+		}
+
+		if (TimeInState < Rule.MinTimeInState)
+		{
+			continue;
+		}
+
+		if (RuleLastUsedTimes.IsValidIndex(RuleIndex) && Now - RuleLastUsedTimes[RuleIndex] < Rule.Cooldown)
+		{
+			continue;
+		}
+
+		bool bGuardsPassed = true;
+		for (const TObjectPtr<UAIStateTransitionGuard>& Guard : Rule.Guards)
+		{
+			if (Guard && !Guard->CanTransition(GetOwner(), FromState, ToState))
+			{
+				bGuardsPassed = false;
+				break;
+			}
+		}
+
+		if (bGuardsPassed)
+		{
+			return RuleIndex;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+double UStateManagerComponent::GetWorldTime() const
+{
+	const UWorld* World = GetWorld();
+	return World ? World->GetTimeSeconds() : 0.0;
+}
+
+void UStateManagerComponent::BindBlackboard(UBlackboardComponent* Blackboard, FBlackboard::FKey AIStateKey)
+{
+	if (StateSubsystem)
+	{
+		StateSubsystem->SetBlackboardMirror(StateHandle, Blackboard, AIStateKey);
+	}
+}
@@ -0,0 +1,9 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Data/AIStateTransition.h"
+
+bool UAIStateTransitionGuard::CanTransition_Implementation(AActor* Agent, EAICharacterState FromState, EAICharacterState ToState) const
+{
+    return true;
+}
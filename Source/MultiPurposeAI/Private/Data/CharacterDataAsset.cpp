@@ -2,9 +2,335 @@
 
 
 #include "Data/CharacterDataAsset.h"
+#include "MultiPurposeAI.h"
+#include "Components/DamageableComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Character.h"
 #include "BehaviorTree/BehaviorTree.h"
+#include "BehaviorTree/BlackboardData.h"
 #include "Engine/SkeletalMesh.h"     
 #include "Animation/AnimInstance.h" 
 #include "Perception/AISenseConfig.h"
 #include "Perception/AIPerceptionTypes.h"
+#include "Perception/AISenseConfig_Sight.h"
+#include "Perception/AISenseConfig_Hearing.h"
+#include "Perception/AISenseConfig_BatchedSight.h"
 
+#if WITH_EDITOR
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/Blueprint.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Engine/SCS_Node.h"
+#include "Engine/SimpleConstructionScript.h"
+#include "FileHelpers.h"
+#include "Kismet2/KismetEditorUtilities.h"
+#include "Misc/PackageName.h"
+#include "Editor.h"
+#endif
+
+const FName UCharacterDataAsset::AIStateKeyName(TEXT("AIState"));
+
+#if WITH_EDITOR
+namespace CharacterArchetypeCache
+{
+    // Archetypes compiled in an older generation are compiled again on their next use
+    static uint32 Generation = 1;
+
+    static void HandleObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& PropertyChangedEvent)
+    {
+        // Subtree and AIState key IDs are resolved against these, and they can be edited between or during PIE sessions
+        if (Object && (Object->IsA<UBehaviorTree>() || Object->IsA<UBlackboardData>()))
+        {
+            ++Generation;
+        }
+    }
+
+    static void RegisterInvalidation()
+    {
+        static bool bRegistered = false;
+        if (bRegistered)
+        {
+            return;
+        }
+        bRegistered = true;
+
+        FCoreUObjectDelegates::OnObjectPropertyChanged.AddStatic(&HandleObjectPropertyChanged);
+
+        // Every PIE session starts from what is on the assets now
+        FEditorDelegates::PreBeginPIE.AddLambda([](const bool bIsSimulating)
+        {
+            ++Generation;
+        });
+    }
+}
+#endif
+
+void UCharacterDataAsset::GetAssetsToPreload(TArray<FSoftObjectPath>& OutAssets) const
+{
+    auto AddAsset = [&OutAssets](const FSoftObjectPath& AssetPath)
+    {
+        if (AssetPath.IsValid())
+        {
+            OutAssets.AddUnique(AssetPath);
+        }
+    };
+
+    AddAsset(CharacterClass.ToSoftObjectPath());
+    if (bUsePrefab)
+    {
+        AddAsset(PrefabClass.ToSoftObjectPath());
+    }
+    AddAsset(CharacterMesh.ToSoftObjectPath());
+    AddAsset(AnimationBlueprint.ToSoftObjectPath());
+    AddAsset(MainBT.ToSoftObjectPath());
+
+    for (const auto& Pair : Subtrees)
+    {
+        AddAsset(Pair.Value.ToSoftObjectPath());
+    }
+}
+
+const FCompiledCharacterArchetype& UCharacterDataAsset::GetCompiledArchetype() const
+{
+#if WITH_EDITOR
+    CharacterArchetypeCache::RegisterInvalidation();
+    if (CompiledArchetype.EditorGeneration != CharacterArchetypeCache::Generation)
+    {
+        const_cast<UCharacterDataAsset*>(this)->CompiledArchetype.bCompiled = false;
+    }
+#endif
+
+    if (!CompiledArchetype.bCompiled)
+    {
+        // Lazily filled cache, the asset itself is not modified
+        const_cast<UCharacterDataAsset*>(this)->CompileArchetype();
+    }
+
+    return CompiledArchetype;
+}
+
+void UCharacterDataAsset::CompileArchetype()
+{
+    FCompiledCharacterArchetype& Compiled = CompiledArchetype;
+    Compiled = FCompiledCharacterArchetype();
+
+    if (bUsePrefab && !PrefabClass.IsNull())
+    {
+        if (bPrefabOutOfDate)
+        {
+            UE_LOG(LogMultiPurposeAI, Warning, TEXT("%s: prefab is out of date, adding components at runtime until it is baked again"), *GetName());
+        }
+        else
+        {
+            Compiled.CharacterClass = PrefabClass.LoadSynchronous();
+            Compiled.bUsesPrefab = Compiled.CharacterClass != nullptr;
+        }
+    }
+    if (!Compiled.CharacterClass)
+    {
+        Compiled.CharacterClass = CharacterClass.LoadSynchronous();
+    }
+    Compiled.CharacterMesh = CharacterMesh.LoadSynchronous();
+    Compiled.AnimationBlueprint = AnimationBlueprint.LoadSynchronous();
+    Compiled.MainBT = MainBT.LoadSynchronous();
+    Compiled.BlackboardAsset = Compiled.MainBT ? Compiled.MainBT->BlackboardAsset : nullptr;
+
+    // The prefab was built with them, spawns get them from its construction script
+    if (bEnableComponents && !Compiled.bUsesPrefab)
+    {
+        for (const TSubclassOf<UActorComponent>& CompClass : ComponentsToAdd)
+        {
+            if (CompClass && CompClass->IsChildOf(UActorComponent::StaticClass()))
+            {
+                Compiled.ComponentClasses.Add(CompClass);
+            }
+        }
+    }
+
+    if (Compiled.BlackboardAsset)
+    {
+        Compiled.AIStateKey = Compiled.BlackboardAsset->GetKeyID(AIStateKeyName);
+    }
+
+    const UEnum* StateEnum = StaticEnum<EAICharacterState>();
+    for (const auto& Pair : Subtrees)
+    {
+        UBehaviorTree* Subtree = Pair.Value.LoadSynchronous();
+        if (!Subtree)
+        {
+            continue;
+        }
+
+        // Blackboard key with the format EnumName + "SubTree" (e.g. "PatrolSubTree")
+        FCompiledSubtreeKey& SubtreeKey = Compiled.SubtreeKeys.AddDefaulted_GetRef();
+        SubtreeKey.State = Pair.Key;
+        SubtreeKey.KeyName = FName(*(StateEnum->GetNameStringByValue(static_cast<int64>(Pair.Key)) + TEXT("SubTree")));
+        SubtreeKey.Subtree = Subtree;
+        SubtreeKey.KeyID = Compiled.BlackboardAsset ? Compiled.BlackboardAsset->GetKeyID(SubtreeKey.KeyName) : FBlackboard::InvalidKey;
+    }
+
+    // ConfigureSense keeps one config per sense class, the last one wins
+    for (const TObjectPtr<UAISenseConfig>& SenseConfig : SensesConfig)
+    {
+        if (!SenseConfig)
+        {
+            continue;
+        }
+
+        const int32 Existing = Compiled.SenseConfigs.IndexOfByPredicate([&SenseConfig](const TObjectPtr<UAISenseConfig>& Other)
+        {
+            return Other->GetClass() == SenseConfig->GetClass();
+        });
+        if (Existing != INDEX_NONE)
+        {
+            Compiled.SenseConfigs[Existing] = SenseConfig;
+        }
+        else
+        {
+            Compiled.SenseConfigs.Add(SenseConfig);
+        }
+    }
+
+    // Scaled sense configs are built once per archetype and tier, enemies only switch between them
+    for (const FAILODTier& Tier : LODTiers)
+    {
+        FCompiledLODTier& CompiledTier = Compiled.LODTiers.AddDefaulted_GetRef();
+        for (const TObjectPtr<UAISenseConfig>& SenseConfig : Compiled.SenseConfigs)
+        {
+            if (FMath::IsNearlyEqual(Tier.SenseRadiusScale, 1.0f))
+            {
+                CompiledTier.SenseConfigs.Add(SenseConfig);
+                continue;
+            }
+
+            UAISenseConfig* ScaledConfig = DuplicateObject<UAISenseConfig>(SenseConfig, this);
+            ScaledConfig->SetFlags(RF_Transient);
+            if (UAISenseConfig_Sight* SightConfig = Cast<UAISenseConfig_Sight>(ScaledConfig))
+            {
+                SightConfig->SightRadius *= Tier.SenseRadiusScale;
+                SightConfig->LoseSightRadius *= Tier.SenseRadiusScale;
+            }
+            else if (UAISenseConfig_BatchedSight* BatchedSightConfig = Cast<UAISenseConfig_BatchedSight>(ScaledConfig))
+            {
+                BatchedSightConfig->SightRadius *= Tier.SenseRadiusScale;
+                BatchedSightConfig->LoseSightRadius *= Tier.SenseRadiusScale;
+            }
+            else if (UAISenseConfig_Hearing* HearingConfig = Cast<UAISenseConfig_Hearing>(ScaledConfig))
+            {
+                HearingConfig->HearingRange *= Tier.SenseRadiusScale;
+            }
+            CompiledTier.SenseConfigs.Add(ScaledConfig);
+        }
+    }
+
+    Compiled.bCompiled = true;
+#if WITH_EDITOR
+    Compiled.EditorGeneration = CharacterArchetypeCache::Generation;
+#endif
+}
+
+#if WITH_EDITOR
+void UCharacterDataAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+
+    CompiledArchetype = FCompiledCharacterArchetype();
+
+    static const TSet<FName> BakedProperties = {
+        GET_MEMBER_NAME_CHECKED(UCharacterDataAsset, CharacterClass),
+        GET_MEMBER_NAME_CHECKED(UCharacterDataAsset, CharacterMesh),
+        GET_MEMBER_NAME_CHECKED(UCharacterDataAsset, AnimationBlueprint),
+        GET_MEMBER_NAME_CHECKED(UCharacterDataAsset, bEnableComponents),
+        GET_MEMBER_NAME_CHECKED(UCharacterDataAsset, ComponentsToAdd),
+        GET_MEMBER_NAME_CHECKED(UCharacterDataAsset, MaxHealth),
+    };
+
+    if (!PrefabClass.IsNull() && BakedProperties.Contains(PropertyChangedEvent.GetMemberPropertyName()))
+    {
+        bPrefabOutOfDate = true;
+    }
+}
+
+void UCharacterDataAsset::BakePrefab()
+{
+    UClass* ParentClass = CharacterClass.LoadSynchronous();
+    if (!ParentClass)
+    {
+        UE_LOG(LogMultiPurposeAI, Warning, TEXT("%s: set CharacterClass before baking a prefab"), *GetName());
+        return;
+    }
+
+    const FString PackageName = GetOutermost()->GetName() + TEXT("_Prefab");
+    const FString AssetName = FPackageName::GetLongPackageAssetName(PackageName);
+    UPackage* Package = CreatePackage(*PackageName);
+
+    UBlueprint* Blueprint = FindObject<UBlueprint>(Package, *AssetName);
+    if (!Blueprint)
+    {
+        Blueprint = FKismetEditorUtilities::CreateBlueprint(ParentClass, Package, FName(*AssetName), BPTYPE_Normal,
+            UBlueprint::StaticClass(), UBlueprintGeneratedClass::StaticClass());
+        FAssetRegistryModule::AssetCreated(Blueprint);
+    }
+    else
+    {
+        // Rebuilt from scratch every bake, the data asset stays the source of truth
+        Blueprint->Modify();
+        Blueprint->ParentClass = ParentClass;
+        for (USCS_Node* Node : Blueprint->SimpleConstructionScript->GetAllNodes())
+        {
+            Blueprint->SimpleConstructionScript->RemoveNode(Node);
+        }
+    }
+
+    if (bEnableComponents)
+    {
+        const AActor* ParentDefaults = ParentClass->GetDefaultObject<AActor>();
+        for (const TSubclassOf<UActorComponent>& CompClass : ComponentsToAdd)
+        {
+            if (!CompClass || ParentDefaults->FindComponentByClass(CompClass))
+            {
+                continue;
+            }
+
+            USCS_Node* Node = Blueprint->SimpleConstructionScript->CreateNode(CompClass);
+            Blueprint->SimpleConstructionScript->AddNode(Node);
+
+            if (UDamageableComponent* DamageableTemplate = Cast<UDamageableComponent>(Node->ComponentTemplate))
+            {
+                DamageableTemplate->DefaultMaxHealth = MaxHealth;
+            }
+        }
+    }
+
+    FKismetEditorUtilities::CompileBlueprint(Blueprint);
+
+    // Inherited mesh component defaults live on the generated class' CDO. Always written, so a cleared override goes
+    // back to what CharacterClass has, like a character spawned without the prefab
+    ACharacter* PrefabDefaults = Blueprint->GeneratedClass->GetDefaultObject<ACharacter>();
+    USkeletalMeshComponent* MeshDefaults = PrefabDefaults ? PrefabDefaults->GetMesh() : nullptr;
+    const USkeletalMeshComponent* ParentMeshDefaults = ParentClass->GetDefaultObject<ACharacter>()->GetMesh();
+    if (MeshDefaults)
+    {
+        USkeletalMesh* Mesh = CharacterMesh.LoadSynchronous();
+        UClass* AnimClass = AnimationBlueprint.LoadSynchronous();
+        MeshDefaults->SetSkeletalMeshAsset(Mesh ? Mesh : (ParentMeshDefaults ? ParentMeshDefaults->GetSkeletalMeshAsset() : nullptr));
+        MeshDefaults->AnimClass = AnimClass ? AnimClass : (ParentMeshDefaults ? ParentMeshDefaults->AnimClass.Get() : nullptr);
+    }
+    Blueprint->MarkPackageDirty();
+
+    Modify();
+    PrefabClass = Blueprint->GeneratedClass.Get();
+    bPrefabOutOfDate = false;
+    CompiledArchetype = FCompiledCharacterArchetype();
+    MarkPackageDirty();
+
+    // The data asset points at the prefab, leaving either unsaved would break the other on the next load
+    if (!UEditorLoadingAndSavingUtils::SavePackages({ Package, GetOutermost() }, false))
+    {
+        UE_LOG(LogMultiPurposeAI, Warning, TEXT("%s: baked prefab %s but could not save it and the data asset"), *GetName(), *PackageName);
+        return;
+    }
+
+    UE_LOG(LogMultiPurposeAI, Log, TEXT("%s: baked prefab %s"), *GetName(), *PackageName);
+}
+#endif
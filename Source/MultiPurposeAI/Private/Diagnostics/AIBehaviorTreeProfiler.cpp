@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Diagnostics/AIBehaviorTreeProfiler.h"
+#include "MultiPurposeAI.h"
+#include "Data/CharacterDataAsset.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/OutputDevice.h"
+#include "Misc/Paths.h"
+
+static TAutoConsoleVariable<bool> CVarProfileBehaviorTrees(
+    TEXT("MultiPurposeAI.ProfileBehaviorTrees"),
+    false,
+    TEXT("Attributes behavior tree cost to the archetype and AI state of every enemy spawned while it is set"));
+
+TMap<TPair<FObjectKey, EAICharacterState>, FAIBehaviorTreeProfileEntry> FAIBehaviorTreeProfiler::Entries;
+bool FAIBehaviorTreeProfiler::bExitHandlerRegistered = false;
+
+namespace AIBehaviorTreeProfiler
+{
+    static FString GetStateName(EAICharacterState State)
+    {
+        return StaticEnum<EAICharacterState>()->GetNameStringByValue(static_cast<int64>(State));
+    }
+}
+
+bool FAIBehaviorTreeProfiler::IsEnabled()
+{
+    return CVarProfileBehaviorTrees.GetValueOnGameThread();
+}
+
+void FAIBehaviorTreeProfiler::Record(const UCharacterDataAsset* DataAsset, EAICharacterState State, double ElapsedMs, double AgentSeconds, bool bExecutionTick, bool bAbortTick)
+{
+    check(IsInGameThread());
+
+    const TPair<FObjectKey, EAICharacterState> Key(FObjectKey(DataAsset), State);
+    FAIBehaviorTreeProfileEntry* Entry = Entries.Find(Key);
+    if (!Entry)
+    {
+        Entry = &Entries.Add(Key);
+        Entry->Archetype = DataAsset ? DataAsset->GetPathName() : TEXT("None");
+        Entry->State = State;
+    }
+    Entry->TotalMs += ElapsedMs;
+    Entry->MaxMs = FMath::Max(Entry->MaxMs, ElapsedMs);
+    ++Entry->Ticks;
+    Entry->ExecutionTicks += bExecutionTick ? 1 : 0;
+    Entry->AbortTicks += bAbortTick ? 1 : 0;
+    Entry->AgentSeconds += AgentSeconds;
+
+    // Headless runs have nobody to type the dump command
+    if (!bExitHandlerRegistered)
+    {
+        FCoreDelegates::OnEnginePreExit.AddStatic(&FAIBehaviorTreeProfiler::HandleEnginePreExit);
+        bExitHandlerRegistered = true;
+    }
+}
+
+void FAIBehaviorTreeProfiler::Reset()
+{
+    Entries.Reset();
+}
+
+void FAIBehaviorTreeProfiler::GetSortedEntries(TArray<const FAIBehaviorTreeProfileEntry*>& OutEntries)
+{
+    OutEntries.Reset(Entries.Num());
+    for (const TPair<TPair<FObjectKey, EAICharacterState>, FAIBehaviorTreeProfileEntry>& Pair : Entries)
+    {
+        OutEntries.Add(&Pair.Value);
+    }
+
+    OutEntries.Sort([](const FAIBehaviorTreeProfileEntry& A, const FAIBehaviorTreeProfileEntry& B)
+    {
+        return A.TotalMs > B.TotalMs;
+    });
+}
+
+void FAIBehaviorTreeProfiler::Dump(FOutputDevice& Ar)
+{
+    if (Entries.Num() == 0)
+    {
+        Ar.Logf(TEXT("No behavior tree profile recorded, set MultiPurposeAI.ProfileBehaviorTrees 1 before the enemies spawn"));
+        return;
+    }
+
+    TArray<const FAIBehaviorTreeProfileEntry*> SortedEntries;
+    GetSortedEntries(SortedEntries);
+
+    Ar.Logf(TEXT("%-48s %-8s %10s %8s %9s %9s %12s %10s %10s"),
+        TEXT("Archetype"), TEXT("State"), TEXT("TotalMs"), TEXT("Ticks"), TEXT("MeanUs"), TEXT("MaxUs"), TEXT("MsPerAgentS"), TEXT("ExecTicks"), TEXT("AbortTicks"));
+
+    for (const FAIBehaviorTreeProfileEntry* Entry : SortedEntries)
+    {
+        const double MeanUs = Entry->Ticks > 0 ? Entry->TotalMs * 1000.0 / Entry->Ticks : 0.0;
+        const double MsPerAgentSecond = Entry->AgentSeconds > 0.0 ? Entry->TotalMs / Entry->AgentSeconds : 0.0;
+
+        Ar.Logf(TEXT("%-48s %-8s %10.3f %8lld %9.2f %9.2f %12.4f %10lld %10lld"),
+            *Entry->Archetype, *AIBehaviorTreeProfiler::GetStateName(Entry->State), Entry->TotalMs, Entry->Ticks,
+            MeanUs, Entry->MaxMs * 1000.0, MsPerAgentSecond, Entry->ExecutionTicks, Entry->AbortTicks);
+    }
+}
+
+FString FAIBehaviorTreeProfiler::WriteCsv()
+{
+    if (Entries.Num() == 0)
+    {
+        return FString();
+    }
+
+    TArray<const FAIBehaviorTreeProfileEntry*> SortedEntries;
+    GetSortedEntries(SortedEntries);
+
+    FString Csv = TEXT("Archetype,State,TotalMs,Ticks,MeanUs,MaxUs,AgentSeconds,MsPerAgentSecond,ExecutionTicks,AbortTicks\n");
+    for (const FAIBehaviorTreeProfileEntry* Entry : SortedEntries)
+    {
+        const double MeanUs = Entry->Ticks > 0 ? Entry->TotalMs * 1000.0 / Entry->Ticks : 0.0;
+        const double MsPerAgentSecond = Entry->AgentSeconds > 0.0 ? Entry->TotalMs / Entry->AgentSeconds : 0.0;
+
+        Csv += FString::Printf(TEXT("%s,%s,%.4f,%lld,%.4f,%.4f,%.4f,%.6f,%lld,%lld\n"),
+            *Entry->Archetype, *AIBehaviorTreeProfiler::GetStateName(Entry->State), Entry->TotalMs, Entry->Ticks,
+            MeanUs, Entry->MaxMs * 1000.0, Entry->AgentSeconds, MsPerAgentSecond, Entry->ExecutionTicks, Entry->AbortTicks);
+    }
+
+    const FString FileName = FPaths::Combine(FPaths::ProfilingDir(), TEXT("MultiPurposeAI"),
+        FString::Printf(TEXT("BehaviorTreeProfile-%s.csv"), *FDateTime::Now().ToString()));
+
+    return FFileHelper::SaveStringToFile(Csv, *FileName) ? FileName : FString();
+}
+
+void FAIBehaviorTreeProfiler::HandleEnginePreExit()
+{
+    const FString FileName = WriteCsv();
+    if (!FileName.IsEmpty())
+    {
+        UE_LOG(LogMultiPurposeAI, Log, TEXT("Behavior tree profile written to %s"), *FileName);
+    }
+}
+
+static void DumpBehaviorTreeProfileCommand(const TArray<FString>& Args, FOutputDevice& Ar)
+{
+    FAIBehaviorTreeProfiler::Dump(Ar);
+
+    if (Args.Contains(TEXT("csv")))
+    {
+        const FString FileName = FAIBehaviorTreeProfiler::WriteCsv();
+        if (!FileName.IsEmpty())
+        {
+            Ar.Logf(TEXT("Behavior tree profile written to %s"), *FileName);
+        }
+    }
+}
+
+static FAutoConsoleCommandWithArgsAndOutputDevice GDumpBehaviorTreeProfileCommand(
+    TEXT("MultiPurposeAI.DumpBehaviorTreeProfile"),
+    TEXT("Prints behavior tree cost per archetype and AI state, add \"csv\" to also write it to Saved/Profiling/MultiPurposeAI"),
+    FConsoleCommandWithArgsAndOutputDeviceDelegate::CreateStatic(&DumpBehaviorTreeProfileCommand));
+
+static FAutoConsoleCommand GResetBehaviorTreeProfileCommand(
+    TEXT("MultiPurposeAI.ResetBehaviorTreeProfile"),
+    TEXT("Clears the behavior tree profile"),
+    FConsoleCommandDelegate::CreateStatic(&FAIBehaviorTreeProfiler::Reset));
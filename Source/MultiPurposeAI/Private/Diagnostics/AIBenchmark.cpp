@@ -0,0 +1,448 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Diagnostics/AIBenchmark.h"
+#include "MultiPurposeAI.h"
+#include "Spawner/EnemySpawner.h"
+#include "Data/CharacterDataAsset.h"
+#include "Subsystems/DamageQueueSubsystem.h"
+#include "AIController.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "Kismet/GameplayStatics.h"
+#include "Perception/AIPerceptionTypes.h"
+#include "Perception/AISense_Sight.h"
+#include "Perception/AISenseConfig_Sight.h"
+#include "Perception/AISenseConfig_BatchedSight.h"
+#include "Perception/AIPerceptionComponent.h"
+#include "Perception/AIPerceptionSystem.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace AIBenchmark
+{
+    static int64 GetUsedMemory()
+    {
+        return static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical);
+    }
+
+    // Times Body once per enemy and records the memory growth of the whole phase
+    template <typename FunctorType>
+    static void MeasurePhase(const TCHAR* Name, const TArray<ACharacter*>& Enemies, TArray<FAIBenchmarkPhase>& OutPhases, FunctorType&& Body)
+    {
+        FAIBenchmarkPhase& Phase = OutPhases.AddDefaulted_GetRef();
+        Phase.Name = Name;
+        Phase.SamplesMs.Reserve(Enemies.Num());
+
+        const int64 MemoryBefore = GetUsedMemory();
+        for (ACharacter* Enemy : Enemies)
+        {
+            const double StartTime = FPlatformTime::Seconds();
+            Body(Enemy);
+            Phase.SamplesMs.Add((FPlatformTime::Seconds() - StartTime) * 1000.0);
+        }
+        Phase.MemoryDeltaBytes = GetUsedMemory() - MemoryBefore;
+    }
+
+    // Times Body NumSamples times, for batch-wide work like a queue flush or a perception system frame
+    template <typename FunctorType>
+    static void MeasureRepeated(const TCHAR* Name, int32 NumSamples, TArray<FAIBenchmarkPhase>& OutPhases, FunctorType&& Body)
+    {
+        FAIBenchmarkPhase& Phase = OutPhases.AddDefaulted_GetRef();
+        Phase.Name = Name;
+        Phase.SamplesMs.Reserve(NumSamples);
+
+        const int64 MemoryBefore = GetUsedMemory();
+        for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+        {
+            const double StartTime = FPlatformTime::Seconds();
+            Body();
+            Phase.SamplesMs.Add((FPlatformTime::Seconds() - StartTime) * 1000.0);
+        }
+        Phase.MemoryDeltaBytes = GetUsedMemory() - MemoryBefore;
+    }
+
+    // Frames of perception system work measured once every enemy is registered
+    static constexpr int32 NumPerceptionFrames = 60;
+
+    // One perception frame with the async trace part of a world tick around it. Traces requested by the senses run
+    // before the frame ends and are read by the next one, so their cost lands in the frame that asked for them
+    static void TickPerceptionFrame(UWorld& World, UAIPerceptionSystem& PerceptionSystem)
+    {
+        World.ResetAsyncTrace();
+        PerceptionSystem.Tick(1.0f / 30.0f);
+        World.FinishAsyncTrace();
+    }
+}
+
+double FAIBenchmarkPhase::GetTotalMs() const
+{
+    double Total = 0.0;
+    for (double Sample : SamplesMs)
+    {
+        Total += Sample;
+    }
+    return Total;
+}
+
+double FAIBenchmarkPhase::GetPercentileMs(float Percentile) const
+{
+    if (SamplesMs.Num() == 0)
+    {
+        return 0.0;
+    }
+
+    TArray<double> Sorted = SamplesMs;
+    Sorted.Sort();
+
+    const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+    return Sorted[Index];
+}
+
+bool FAIBenchmark::Run(UWorld* World, UCharacterDataAsset* DataAsset, const TArray<int32>& EnemyCounts, bool bComparePerceptionSetup, bool bCompareSight, FOutputDevice& Ar)
+{
+    if (!World || !DataAsset || !DataAsset->GetCompiledArchetype().CharacterClass)
+    {
+        Ar.Logf(TEXT("MultiPurposeAI.Benchmark needs a game world and a data asset with a valid CharacterClass"));
+        return false;
+    }
+
+    TArray<FAIBenchmarkRun> Results;
+    for (int32 EnemyCount : EnemyCounts)
+    {
+        if (EnemyCount <= 0)
+        {
+            continue;
+        }
+
+        FAIBenchmarkRun& Batched = Results.AddDefaulted_GetRef();
+        Batched.EnemyCount = EnemyCount;
+        Batched.bCompareSight = bCompareSight;
+        RunOnce(World, DataAsset, Batched);
+
+        if (bComparePerceptionSetup)
+        {
+            FAIBenchmarkRun& PerAgent = Results.AddDefaulted_GetRef();
+            PerAgent.EnemyCount = EnemyCount;
+            PerAgent.bBatchPerceptionSetup = false;
+            RunOnce(World, DataAsset, PerAgent);
+        }
+    }
+
+    WriteResults(DataAsset, Results, Ar);
+    return Results.Num() > 0;
+}
+
+void FAIBenchmark::RunOnce(UWorld* World, UCharacterDataAsset* DataAsset, FAIBenchmarkRun& Run)
+{
+    const int32 EnemyCount = Run.EnemyCount;
+    TArray<FAIBenchmarkPhase>& OutPhases = Run.Phases;
+
+    FActorSpawnParameters SpawnParams;
+    SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+    // Not started through BeginPlay spawns: the spawner's own list stays empty and everything is driven from here
+    AEnemySpawner* Spawner = World->SpawnActor<AEnemySpawner>(AEnemySpawner::StaticClass(), FTransform::Identity, SpawnParams);
+    AActor* Target = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+    if (!Spawner || !Target)
+    {
+        return;
+    }
+
+    Spawner->bUsePooling = false;
+    Spawner->bTimeSliceSpawning = false;
+    Spawner->bBatchPerceptionSetup = Run.bBatchPerceptionSetup;
+
+    // Spread on a grid so collision adjustment does not dominate the spawn timings
+    const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(EnemyCount)));
+    TArray<FEnemySpawnData> SpawnEntries;
+    SpawnEntries.SetNum(EnemyCount);
+    for (int32 Index = 0; Index < EnemyCount; ++Index)
+    {
+        SpawnEntries[Index].EnemyDataAsset = DataAsset;
+        SpawnEntries[Index].SpawnTransform.SetLocation(FVector((Index % GridSize) * 300.0f, (Index / GridSize) * 300.0f, 100.0f));
+    }
+
+    // Spawn is timed per entry, the later phases per spawned enemy
+    TArray<ACharacter*> Enemies;
+    Enemies.Reserve(EnemyCount);
+    {
+        FAIBenchmarkPhase& Phase = OutPhases.AddDefaulted_GetRef();
+        Phase.Name = TEXT("Spawn");
+        Phase.SamplesMs.Reserve(EnemyCount);
+
+        // Spawned as one batch like a queue slice, the registration is timed on its own below
+        TGuardValue<bool> SpawnBatchGuard(Spawner->bInSpawnBatch, true);
+
+        const int64 MemoryBefore = AIBenchmark::GetUsedMemory();
+        for (const FEnemySpawnData& Entry : SpawnEntries)
+        {
+            const double StartTime = FPlatformTime::Seconds();
+            ACharacter* Enemy = Spawner->SpawnEnemy(Entry);
+            Phase.SamplesMs.Add((FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+            if (Enemy)
+            {
+                Enemies.Add(Enemy);
+            }
+        }
+        Phase.MemoryDeltaBytes = AIBenchmark::GetUsedMemory() - MemoryBefore;
+    }
+    Run.NumSpawned = Enemies.Num();
+
+    // Initialization on its own, on characters that have a controller and a record but none of the archetype setup yet,
+    // as CreateEnemy hands them to InitializeEnemy. The spawned enemies above are already set up and would skip the work
+    {
+        const FCompiledCharacterArchetype& Archetype = DataAsset->GetCompiledArchetype();
+        TArray<ACharacter*> FreshCharacters;
+        FreshCharacters.Reserve(EnemyCount);
+        for (const FEnemySpawnData& Entry : SpawnEntries)
+        {
+            ACharacter* Character = World->SpawnActor<ACharacter>(Archetype.CharacterClass, Entry.SpawnTransform, SpawnParams);
+            if (!Character)
+            {
+                continue;
+            }
+            if (!Character->GetController())
+            {
+                Character->SpawnDefaultController();
+            }
+
+            FSpawnedEnemyRecord& Record = Spawner->EnemyRecords.Add(Character);
+            Record.DataAsset = DataAsset;
+            Record.Controller = Cast<AAIController>(Character->GetController());
+            FreshCharacters.Add(Character);
+        }
+
+        AIBenchmark::MeasurePhase(TEXT("Initialize"), FreshCharacters, OutPhases, [Spawner, DataAsset](ACharacter* Character)
+        {
+            if (AAIController* Controller = Spawner->EnemyRecords.FindChecked(Character).Controller)
+            {
+                Spawner->InitializeEnemy(Character, DataAsset, Controller);
+            }
+        });
+
+        for (ACharacter* Character : FreshCharacters)
+        {
+            Spawner->DestroyEnemy(Character);
+        }
+    }
+
+    // Part of the spawn cost, split out because the batched setup defers it to the end of the batch
+    AIBenchmark::MeasureRepeated(TEXT("PerceptionRegistration"), 1, OutPhases, [Spawner]()
+    {
+        Spawner->FlushPerceptionRegistrations();
+    });
+
+    // Steady state sense processing with every listener registered
+    if (UAIPerceptionSystem* PerceptionSystem = UAIPerceptionSystem::GetCurrent(World))
+    {
+        AIBenchmark::MeasureRepeated(TEXT("PerceptionSystemFrame"), AIBenchmark::NumPerceptionFrames, OutPhases, [World, PerceptionSystem]()
+        {
+            AIBenchmark::TickPerceptionFrame(*World, *PerceptionSystem);
+        });
+
+        if (Run.bCompareSight)
+        {
+            // Every enemy is a listener and a target of both senses, only one of them enabled at a time
+            UAISenseConfig_BatchedSight* BatchedConfig = NewObject<UAISenseConfig_BatchedSight>(GetTransientPackage());
+            UAISenseConfig_Sight* StockConfig = NewObject<UAISenseConfig_Sight>(GetTransientPackage());
+            StockConfig->SightRadius = BatchedConfig->SightRadius;
+            StockConfig->LoseSightRadius = BatchedConfig->LoseSightRadius;
+            StockConfig->PeripheralVisionAngleDegrees = BatchedConfig->PeripheralVisionAngleDegrees;
+            StockConfig->DetectionByAffiliation = BatchedConfig->DetectionByAffiliation;
+
+            auto MeasureSight = [&Enemies, &OutPhases, World, PerceptionSystem](const TCHAR* Name, UAISenseConfig& Config, TSubclassOf<UAISense> OtherSense)
+            {
+                for (ACharacter* Enemy : Enemies)
+                {
+                    const AAIController* Controller = Cast<AAIController>(Enemy->GetController());
+                    if (UAIPerceptionComponent* PerceptionComponent = Controller ? Controller->GetPerceptionComponent() : nullptr)
+                    {
+                        PerceptionComponent->ConfigureSense(Config);
+                        PerceptionComponent->SetSenseEnabled(OtherSense, false);
+                        PerceptionComponent->SetSenseEnabled(Config.GetSenseImplementation(), true);
+                    }
+                }
+
+                // Listener updates are processed here, outside of the measured frames
+                AIBenchmark::TickPerceptionFrame(*World, *PerceptionSystem);
+
+                AIBenchmark::MeasureRepeated(Name, AIBenchmark::NumPerceptionFrames, OutPhases, [World, PerceptionSystem]()
+                {
+                    AIBenchmark::TickPerceptionFrame(*World, *PerceptionSystem);
+                });
+            };
+
+            MeasureSight(TEXT("StockSightFrame"), *StockConfig, UAISense_BatchedSight::StaticClass());
+            MeasureSight(TEXT("BatchedSightFrame"), *BatchedConfig, UAISense_Sight::StaticClass());
+        }
+    }
+
+    const FAIStimulus Stimulus(*GetDefault<UAISense_Sight>(), 1.0f, Target->GetActorLocation(), FVector::ZeroVector);
+    AIBenchmark::MeasurePhase(TEXT("PerceptionDispatch"), Enemies, OutPhases, [Spawner, Target, &Stimulus](ACharacter* Enemy)
+    {
+        Spawner->HandleTargetPerceptionUpdated(Enemy, Target, Stimulus);
+    });
+
+    // Snapshot blob of every live enemy, restored through the spawner which respawns the whole batch
+    TArray<uint8> Snapshot;
+    AIBenchmark::MeasureRepeated(TEXT("SnapshotSave"), 10, OutPhases, [Spawner, &Snapshot]()
+    {
+        Spawner->SaveSnapshot(Snapshot);
+    });
+    OutPhases.Last().PayloadBytes = Snapshot.Num();
+
+    AIBenchmark::MeasureRepeated(TEXT("SnapshotRestore"), 1, OutPhases, [Spawner, &Snapshot]()
+    {
+        Spawner->RestoreSnapshot(Snapshot);
+    });
+    OutPhases.Last().PayloadBytes = Snapshot.Num();
+
+    // Without pooling the restore spawned new characters
+    Enemies.Reset();
+    for (ACharacter* Enemy : Spawner->SpawnedEnemies)
+    {
+        Enemies.Add(Enemy);
+    }
+    Run.NumRestored = Enemies.Num();
+
+    AIBenchmark::MeasurePhase(TEXT("DamageAndDeath"), Enemies, OutPhases, [Target](ACharacter* Enemy)
+    {
+        UGameplayStatics::ApplyDamage(Enemy, TNumericLimits<float>::Max(), nullptr, Target, nullptr);
+    });
+
+    // Queued hits are only resolved here, in one pass for the whole batch
+    if (UDamageQueueSubsystem* DamageQueue = World->GetSubsystem<UDamageQueueSubsystem>())
+    {
+        AIBenchmark::MeasureRepeated(TEXT("DamageQueueResolve"), 1, OutPhases, [DamageQueue]()
+        {
+            DamageQueue->ProcessPendingDamage();
+        });
+    }
+
+    // Every enemy that can take damage should be a corpse by now
+    for (const TObjectPtr<ACharacter>& Enemy : Spawner->SpawnedEnemies)
+    {
+        const FSpawnedEnemyRecord* Record = Spawner->EnemyRecords.Find(Enemy);
+        if (Record && Record->DamageComponent)
+        {
+            ++Run.NumSurvivedLethalDamage;
+        }
+    }
+
+    // Corpses are only recycled by the spawner's tick, tear everything down here
+    for (ACharacter* Enemy : Enemies)
+    {
+        if (IsValid(Enemy))
+        {
+            if (AController* Controller = Enemy->GetController())
+            {
+                Controller->Destroy();
+            }
+            Enemy->Destroy();
+        }
+    }
+    Spawner->Destroy();
+    Target->Destroy();
+
+    CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
+
+void FAIBenchmark::WriteResults(const UCharacterDataAsset* DataAsset, const TArray<FAIBenchmarkRun>& Results, FOutputDevice& Ar)
+{
+    FString Csv = TEXT("DataAsset,EnemyCount,PerceptionSetup,Phase,TotalMs,MeanMs,P50Ms,P99Ms,MaxMs,MemoryDeltaBytes,PayloadBytes\n");
+    FString Json = TEXT("{\n");
+    Json += FString::Printf(TEXT("  \"dataAsset\": \"%s\",\n  \"runs\": ["), *GetNameSafe(DataAsset));
+
+    bool bFirstRun = true;
+    for (const FAIBenchmarkRun& Run : Results)
+    {
+        const TCHAR* PerceptionSetup = Run.bBatchPerceptionSetup ? TEXT("Batched") : TEXT("PerAgent");
+        Json += FString::Printf(TEXT("%s\n    { \"enemyCount\": %d, \"perceptionSetup\": \"%s\", \"phases\": ["),
+            bFirstRun ? TEXT("") : TEXT(","), Run.EnemyCount, PerceptionSetup);
+        bFirstRun = false;
+
+        bool bFirstPhase = true;
+        for (const FAIBenchmarkPhase& Phase : Run.Phases)
+        {
+            const double Total = Phase.GetTotalMs();
+            const double Mean = Phase.SamplesMs.Num() > 0 ? Total / Phase.SamplesMs.Num() : 0.0;
+            const double P50 = Phase.GetPercentileMs(0.5f);
+            const double P99 = Phase.GetPercentileMs(0.99f);
+            const double Max = Phase.GetPercentileMs(1.0f);
+
+            Csv += FString::Printf(TEXT("%s,%d,%s,%s,%.4f,%.4f,%.4f,%.4f,%.4f,%lld,%lld\n"),
+                *GetNameSafe(DataAsset), Run.EnemyCount, PerceptionSetup, *Phase.Name, Total, Mean, P50, P99, Max, Phase.MemoryDeltaBytes, Phase.PayloadBytes);
+
+            Json += FString::Printf(TEXT("%s\n      { \"phase\": \"%s\", \"totalMs\": %.4f, \"meanMs\": %.4f, \"p50Ms\": %.4f, \"p99Ms\": %.4f, \"maxMs\": %.4f, \"memoryDeltaBytes\": %lld, \"payloadBytes\": %lld }"),
+                bFirstPhase ? TEXT("") : TEXT(","), *Phase.Name, Total, Mean, P50, P99, Max, Phase.MemoryDeltaBytes, Phase.PayloadBytes);
+            bFirstPhase = false;
+
+            Ar.Logf(TEXT("%6d %-8s %-22s total %10.3f ms  p50 %8.4f ms  p99 %8.4f ms  mem %+lld bytes"),
+                Run.EnemyCount, PerceptionSetup, *Phase.Name, Total, P50, P99, Phase.MemoryDeltaBytes);
+        }
+
+        Json += TEXT("\n    ] }");
+    }
+    Json += TEXT("\n  ]\n}\n");
+
+    const FString BaseName = FPaths::Combine(FPaths::ProfilingDir(), TEXT("MultiPurposeAI"),
+        FString::Printf(TEXT("Benchmark-%s-%s"), *GetNameSafe(DataAsset), *FDateTime::Now().ToString()));
+
+    FFileHelper::SaveStringToFile(Csv, *(BaseName + TEXT(".csv")));
+    FFileHelper::SaveStringToFile(Json, *(BaseName + TEXT(".json")));
+
+    Ar.Logf(TEXT("Benchmark results written to %s.csv/.json"), *BaseName);
+}
+
+static void RunAIBenchmarkCommand(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+{
+    if (Args.Num() == 0)
+    {
+        Ar.Logf(TEXT("Usage: MultiPurposeAI.Benchmark <DataAssetPath> [EnemyCount...] [compareperception] [comparesight], counts default to 100 1000 5000"));
+        return;
+    }
+
+    UCharacterDataAsset* DataAsset = LoadObject<UCharacterDataAsset>(nullptr, *Args[0]);
+    if (!DataAsset)
+    {
+        Ar.Logf(TEXT("Could not load UCharacterDataAsset %s"), *Args[0]);
+        return;
+    }
+
+    TArray<int32> EnemyCounts;
+    bool bComparePerceptionSetup = false;
+    bool bCompareSight = false;
+    for (int32 Index = 1; Index < Args.Num(); ++Index)
+    {
+        if (Args[Index].Equals(TEXT("compareperception"), ESearchCase::IgnoreCase))
+        {
+            bComparePerceptionSetup = true;
+        }
+        else if (Args[Index].Equals(TEXT("comparesight"), ESearchCase::IgnoreCase))
+        {
+            bCompareSight = true;
+        }
+        else
+        {
+            EnemyCounts.Add(FCString::Atoi(*Args[Index]));
+        }
+    }
+    if (EnemyCounts.Num() == 0)
+    {
+        EnemyCounts = { 100, 1000, 5000 };
+    }
+
+    FAIBenchmark::Run(World, DataAsset, EnemyCounts, bComparePerceptionSetup, bCompareSight, Ar);
+}
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice GAIBenchmarkCommand(
+    TEXT("MultiPurposeAI.Benchmark"),
+    TEXT("Spawns N enemies of a data asset and writes spawn/init/perception/damage timings to Saved/Profiling/MultiPurposeAI"),
+    FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&RunAIBenchmarkCommand));
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Diagnostics/AIDiagnostics.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/OutputDevice.h"
+
+std::atomic<int64> FAIDiagnostics::Counters[static_cast<uint8>(EAIDiagnosticCounter::Num)] = {};
+
+const TCHAR* FAIDiagnostics::GetCounterName(EAIDiagnosticCounter Counter)
+{
+    switch (Counter)
+    {
+    case EAIDiagnosticCounter::EnemiesCreated:             return TEXT("EnemiesCreated");
+    case EAIDiagnosticCounter::EnemiesAcquiredFromPool:    return TEXT("EnemiesAcquiredFromPool");
+    case EAIDiagnosticCounter::EnemiesReleased:            return TEXT("EnemiesReleased");
+    case EAIDiagnosticCounter::ComponentsAdded:            return TEXT("ComponentsAdded");
+    case EAIDiagnosticCounter::SensesConfigured:           return TEXT("SensesConfigured");
+    case EAIDiagnosticCounter::PerceptionEvents:           return TEXT("PerceptionEvents");
+    case EAIDiagnosticCounter::Detections:                 return TEXT("Detections");
+    case EAIDiagnosticCounter::DamageEvents:               return TEXT("DamageEvents");
+    case EAIDiagnosticCounter::Deaths:                     return TEXT("Deaths");
+    case EAIDiagnosticCounter::SubtreesRun:                return TEXT("SubtreesRun");
+    case EAIDiagnosticCounter::SubtreesInjected:           return TEXT("SubtreesInjected");
+    case EAIDiagnosticCounter::StreamingCellsActivated:    return TEXT("StreamingCellsActivated");
+    case EAIDiagnosticCounter::StreamingCellsDeactivated:  return TEXT("StreamingCellsDeactivated");
+    case EAIDiagnosticCounter::SpawnPointsSnapped:         return TEXT("SpawnPointsSnapped");
+    case EAIDiagnosticCounter::SpawnPointsRejected:        return TEXT("SpawnPointsRejected");
+    case EAIDiagnosticCounter::BlackboardWritesApplied:    return TEXT("BlackboardWritesApplied");
+    case EAIDiagnosticCounter::BlackboardWritesSuppressed: return TEXT("BlackboardWritesSuppressed");
+    case EAIDiagnosticCounter::SightTracesStarted:         return TEXT("SightTracesStarted");
+    case EAIDiagnosticCounter::SightCacheHits:             return TEXT("SightCacheHits");
+    default:                                               return TEXT("Unknown");
+    }
+}
+
+void FAIDiagnostics::Reset()
+{
+    for (std::atomic<int64>& Counter : Counters)
+    {
+        Counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+void FAIDiagnostics::Dump(FOutputDevice& Ar)
+{
+#if !MPAI_WITH_DIAGNOSTICS
+    Ar.Logf(TEXT("MultiPurposeAI counters are compiled out of this build"));
+#endif
+
+    for (uint8 Index = 0; Index < static_cast<uint8>(EAIDiagnosticCounter::Num); ++Index)
+    {
+        const EAIDiagnosticCounter Counter = static_cast<EAIDiagnosticCounter>(Index);
+        Ar.Logf(TEXT("%-26s %lld"), GetCounterName(Counter), Get(Counter));
+    }
+}
+
+static FAutoConsoleCommandWithOutputDevice GDumpAICountersCommand(
+    TEXT("MultiPurposeAI.DumpCounters"),
+    TEXT("Prints the MultiPurposeAI event counters"),
+    FConsoleCommandWithOutputDeviceDelegate::CreateStatic(&FAIDiagnostics::Dump));
+
+static FAutoConsoleCommand GResetAICountersCommand(
+    TEXT("MultiPurposeAI.ResetCounters"),
+    TEXT("Resets the MultiPurposeAI event counters"),
+    FConsoleCommandDelegate::CreateStatic(&FAIDiagnostics::Reset));
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Diagnostics/AIStats.h"
+
+DEFINE_STAT(STAT_MPAI_SpawnEnemy);
+DEFINE_STAT(STAT_MPAI_InitializeEnemy);
+DEFINE_STAT(STAT_MPAI_AddComponents);
+DEFINE_STAT(STAT_MPAI_AssignPerceptionConfig);
+DEFINE_STAT(STAT_MPAI_PerceptionUpdated);
+DEFINE_STAT(STAT_MPAI_RunBehaviorTreeFromBB);
+DEFINE_STAT(STAT_MPAI_TakeDamage);
+DEFINE_STAT(STAT_MPAI_ProcessDamage);
+DEFINE_STAT(STAT_MPAI_LODPass);
+DEFINE_STAT(STAT_MPAI_StreamingUpdate);
+DEFINE_STAT(STAT_MPAI_SaveSnapshot);
+DEFINE_STAT(STAT_MPAI_RestoreSnapshot);
+DEFINE_STAT(STAT_MPAI_CrowdUpdate);
+DEFINE_STAT(STAT_MPAI_ValidateSpawnPoints);
+DEFINE_STAT(STAT_MPAI_BlackboardFlush);
+DEFINE_STAT(STAT_MPAI_BatchedSightUpdate);
+
+DEFINE_STAT(STAT_MPAI_LiveAgents);
+DEFINE_STAT(STAT_MPAI_PooledAgents);
+DEFINE_STAT(STAT_MPAI_CrowdEntities);
+DEFINE_STAT(STAT_MPAI_CrowdPromoted);
+DEFINE_STAT(STAT_MPAI_StateChanges);
+DEFINE_STAT(STAT_MPAI_BlackboardWritesSuppressed);
+
+UE_TRACE_CHANNEL_DEFINE(MultiPurposeAIChannel);
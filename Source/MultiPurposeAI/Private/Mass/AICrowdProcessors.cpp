@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Mass/AICrowdProcessors.h"
+#include "Mass/AICrowdFragments.h"
+#include "MassExecutionContext.h"
+
+UAICrowdSignificanceProcessor::UAICrowdSignificanceProcessor()
+    : EntityQuery(*this)
+{
+    bAutoRegisterWithProcessingPhases = false;
+}
+
+void UAICrowdSignificanceProcessor::ConfigureQueries()
+{
+    EntityQuery.AddRequirement<FAICrowdTransformFragment>(EMassFragmentAccess::ReadOnly);
+    EntityQuery.AddRequirement<FAICrowdHealthFragment>(EMassFragmentAccess::ReadOnly);
+    EntityQuery.AddRequirement<FAICrowdRepresentationFragment>(EMassFragmentAccess::ReadOnly);
+}
+
+void UAICrowdSignificanceProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+    EntitiesToPromote.Reset();
+    EntitiesToDemote.Reset();
+    DeadEntities.Reset();
+
+    // Entities between the two radii keep whatever representation they have
+    const double PromoteDistanceSquared = FMath::Square(PromoteRadius);
+    const double DemoteDistanceSquared = FMath::Square(FMath::Max(DemoteRadius, PromoteRadius));
+
+    EntityQuery.ParallelForEachEntityChunk(EntityManager, Context, [this, PromoteDistanceSquared, DemoteDistanceSquared](FMassExecutionContext& ChunkContext)
+    {
+        const TConstArrayView<FAICrowdTransformFragment> Transforms = ChunkContext.GetFragmentView<FAICrowdTransformFragment>();
+        const TConstArrayView<FAICrowdHealthFragment> Healths = ChunkContext.GetFragmentView<FAICrowdHealthFragment>();
+        const TConstArrayView<FAICrowdRepresentationFragment> Representations = ChunkContext.GetFragmentView<FAICrowdRepresentationFragment>();
+
+        TArray<FMassEntityHandle, TInlineAllocator<16>> Promote;
+        TArray<FMassEntityHandle, TInlineAllocator<16>> Demote;
+        TArray<FMassEntityHandle, TInlineAllocator<16>> Dead;
+
+        for (int32 Index = 0; Index < ChunkContext.GetNumEntities(); ++Index)
+        {
+            // Promoted enemies die through their character, the spawner reports those. Archetypes without health never die here
+            if (!Representations[Index].bHasActor && Healths[Index].MaxHealth > 0.0f && Healths[Index].CurrentHealth <= 0.0f)
+            {
+                Dead.Add(ChunkContext.GetEntity(Index));
+                continue;
+            }
+
+            const FVector Location = Transforms[Index].Transform.GetLocation();
+            double ClosestDistanceSquared = TNumericLimits<double>::Max();
+            for (const FVector& SourceLocation : SourceLocations)
+            {
+                ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, FVector::DistSquared(SourceLocation, Location));
+            }
+
+            if (!Representations[Index].bHasActor && ClosestDistanceSquared <= PromoteDistanceSquared)
+            {
+                Promote.Add(ChunkContext.GetEntity(Index));
+            }
+            else if (Representations[Index].bHasActor && ClosestDistanceSquared > DemoteDistanceSquared)
+            {
+                Demote.Add(ChunkContext.GetEntity(Index));
+            }
+        }
+
+        if (Promote.Num() > 0 || Demote.Num() > 0 || Dead.Num() > 0)
+        {
+            FScopeLock Lock(&OutputLock);
+            EntitiesToPromote.Append(Promote);
+            EntitiesToDemote.Append(Demote);
+            DeadEntities.Append(Dead);
+        }
+    });
+}
@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Perception/AISenseConfig_BatchedSight.h"
+
+UAISenseConfig_BatchedSight::UAISenseConfig_BatchedSight(const FObjectInitializer& ObjectInitializer)
+    : Super(ObjectInitializer)
+{
+    DebugColor = FColor::Green;
+    Implementation = UAISense_BatchedSight::StaticClass();
+
+    // Enemies are on no team by default, so players read as neutral
+    DetectionByAffiliation.bDetectEnemies = true;
+    DetectionByAffiliation.bDetectNeutrals = true;
+}
+
+TSubclassOf<UAISense> UAISenseConfig_BatchedSight::GetSenseImplementation() const
+{
+    return Implementation;
+}
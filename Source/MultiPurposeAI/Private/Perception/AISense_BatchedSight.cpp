@@ -0,0 +1,362 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Perception/AISense_BatchedSight.h"
+#include "Perception/AISenseConfig_BatchedSight.h"
+#include "Diagnostics/AIDiagnostics.h"
+#include "Diagnostics/AIStats.h"
+#include "Perception/AIPerceptionComponent.h"
+#include "Perception/AIPerceptionSystem.h"
+#include "GenericTeamAgentInterface.h"
+#include "Engine/World.h"
+#include "Math/VectorRegister.h"
+
+namespace AISenseBatchedSight
+{
+    // Unused and padding lanes sit here, out of every sight radius without overflowing when squared
+    static constexpr float FarAwayCoordinate = 1.0e18f;
+
+    static constexpr uint8 AllAffiliationFlags = (1 << ETeamAttitude::Friendly) | (1 << ETeamAttitude::Neutral) | (1 << ETeamAttitude::Hostile);
+}
+
+UAISense_BatchedSight::UAISense_BatchedSight(const FObjectInitializer& ObjectInitializer)
+    : Super(ObjectInitializer)
+{
+    if (!HasAnyFlags(RF_ClassDefaultObject))
+    {
+        OnNewListenerDelegate.BindUObject(this, &UAISense_BatchedSight::OnNewListenerImpl);
+        OnListenerUpdateDelegate.BindUObject(this, &UAISense_BatchedSight::OnListenerUpdateImpl);
+        OnListenerRemovedDelegate.BindUObject(this, &UAISense_BatchedSight::OnListenerRemovedImpl);
+    }
+
+    // Players and every other pawn can be seen without registering them by hand, like the stock sight
+    bAutoRegisterAllPawnsAsSources = true;
+}
+
+void UAISense_BatchedSight::RegisterSource(AActor& SourceActor)
+{
+    if (TargetIndices.Contains(&SourceActor))
+    {
+        return;
+    }
+
+    int32 Index;
+    if (FreeTargetSlots.Num() > 0)
+    {
+        Index = FreeTargetSlots.Pop(false);
+    }
+    else
+    {
+        Index = Targets.AddDefaulted();
+    }
+
+    Targets[Index] = &SourceActor;
+    TargetIndices.Add(&SourceActor, Index);
+}
+
+void UAISense_BatchedSight::UnregisterSource(AActor& SourceActor)
+{
+    int32 Index;
+    if (TargetIndices.RemoveAndCopyValue(&SourceActor, Index))
+    {
+        Targets[Index] = nullptr;
+        ReleasedTargetSlots.Add(Index);
+    }
+}
+
+void UAISense_BatchedSight::OnNewListenerImpl(const FPerceptionListener& NewListener)
+{
+    DigestListener(NewListener);
+}
+
+void UAISense_BatchedSight::OnListenerUpdateImpl(const FPerceptionListener& UpdatedListener)
+{
+    // E.g. AI LOD switched the listener to a config with scaled radii
+    DigestListener(UpdatedListener);
+}
+
+void UAISense_BatchedSight::OnListenerRemovedImpl(const FPerceptionListener& RemovedListener)
+{
+    // Its pairs stop being candidates and are dropped by the next update
+    DigestedProperties.Remove(RemovedListener.GetListenerID());
+}
+
+void UAISense_BatchedSight::DigestListener(const FPerceptionListener& Listener)
+{
+    const UAIPerceptionComponent* ListenerComponent = Listener.Listener.Get();
+    const UAISenseConfig_BatchedSight* Config = ListenerComponent
+        ? Cast<const UAISenseConfig_BatchedSight>(ListenerComponent->GetSenseConfig(GetSenseID()))
+        : nullptr;
+
+    if (!Config || !Listener.HasSense(GetSenseID()))
+    {
+        DigestedProperties.Remove(Listener.GetListenerID());
+        return;
+    }
+
+    FDigestedSightProperties& Properties = DigestedProperties.FindOrAdd(Listener.GetListenerID());
+    Properties.SightRadiusSq = FMath::Square(Config->SightRadius);
+    Properties.LoseSightRadiusSq = FMath::Square(FMath::Max(Config->LoseSightRadius, Config->SightRadius));
+    Properties.PeripheralVisionCos = FMath::Cos(FMath::DegreesToRadians(Config->PeripheralVisionAngleDegrees));
+    Properties.AffiliationFlags = Config->DetectionByAffiliation.GetAsFlags();
+}
+
+float UAISense_BatchedSight::Update()
+{
+    MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_BatchedSightUpdate);
+
+    UWorld* World = GetWorld();
+    if (!World)
+    {
+        return SuspendNextUpdate;
+    }
+
+    ++UpdateCounter;
+    AIPerception::FListenerMap& ListenersMap = *GetListeners();
+
+    CollectTraceResults(*World);
+    GatherTargets();
+
+    CandidatePairs.Reset();
+    for (AIPerception::FListenerMap::TIterator ListenerIt(ListenersMap); ListenerIt; ++ListenerIt)
+    {
+        const FDigestedSightProperties* Properties = DigestedProperties.Find(ListenerIt->Key);
+        if (Properties && ListenerIt->Value.Listener.IsValid())
+        {
+            GatherCandidates(ListenerIt->Key, ListenerIt->Value, *Properties);
+        }
+    }
+
+    // Traces go round the candidates, so with a small budget every pair still gets its turn
+    const double Now = World->GetTimeSeconds();
+    const int32 NumCandidates = CandidatePairs.Num();
+    const int32 FirstCandidate = NumCandidates > 0 ? TraceCursor % NumCandidates : 0;
+    int32 TracesStarted = 0;
+    int32 CacheHits = 0;
+    TraceCursor = 0;
+
+    for (int32 Offset = 0; Offset < NumCandidates; ++Offset)
+    {
+        const int32 CandidateIndex = (FirstCandidate + Offset) % NumCandidates;
+        FSightPair& Pair = Pairs.FindChecked(CandidatePairs[CandidateIndex]);
+        FPerceptionListener* Listener = ListenersMap.Find(Pair.ListenerId);
+        AActor* Target = Targets[Pair.TargetIndex].Get();
+        if (!Listener || !Target)
+        {
+            continue;
+        }
+
+        const bool bResultExpired = Pair.TraceTime < 0.0 || Now - Pair.TraceTime >= VisibilityCacheTime;
+        if (!bResultExpired)
+        {
+            ++CacheHits;
+        }
+        else if (!Pair.PendingTrace.IsValid() && TracesStarted < MaxTracesPerUpdate)
+        {
+            StartTrace(*World, *Listener, *Target, Pair);
+            if (++TracesStarted == MaxTracesPerUpdate)
+            {
+                TraceCursor = CandidateIndex + 1;
+            }
+        }
+
+        // Like the stock sight, every check that still sees the target refreshes its last sensed location
+        if (Pair.bVisible != Pair.bReportedVisible || (Pair.bVisible && Pair.bNewResult))
+        {
+            ReportStimulus(*Listener, *Target, Pair.bVisible);
+            Pair.bReportedVisible = Pair.bVisible;
+        }
+        Pair.bNewResult = false;
+    }
+
+    MPAI_COUNT_N(SightTracesStarted, TracesStarted);
+    MPAI_COUNT_N(SightCacheHits, CacheHits);
+
+    // Pairs out of range or cone this update, or whose listener or target went away
+    for (TMap<FSightPairKey, FSightPair>::TIterator PairIt = Pairs.CreateIterator(); PairIt; ++PairIt)
+    {
+        FSightPair& Pair = PairIt.Value();
+        if (Pair.LastCandidateUpdate == UpdateCounter)
+        {
+            continue;
+        }
+
+        if (Pair.bReportedVisible)
+        {
+            FPerceptionListener* Listener = ListenersMap.Find(Pair.ListenerId);
+            AActor* Target = Targets[Pair.TargetIndex].Get();
+            if (Listener && Target)
+            {
+                ReportStimulus(*Listener, *Target, false);
+            }
+        }
+        PairIt.RemoveCurrent();
+    }
+
+    // No pair refers to these slots anymore
+    FreeTargetSlots.Append(ReleasedTargetSlots);
+    ReleasedTargetSlots.Reset();
+
+    return 0.0f;
+}
+
+void UAISense_BatchedSight::GatherTargets()
+{
+    const int32 NumLanes = Align(Targets.Num(), 4);
+    TargetX.SetNumUninitialized(NumLanes, false);
+    TargetY.SetNumUninitialized(NumLanes, false);
+    TargetZ.SetNumUninitialized(NumLanes, false);
+
+    for (int32 Index = 0; Index < NumLanes; ++Index)
+    {
+        const AActor* Target = Index < Targets.Num() ? Targets[Index].Get() : nullptr;
+        if (Target)
+        {
+            const FVector Location = Target->GetActorLocation();
+            TargetX[Index] = static_cast<float>(Location.X);
+            TargetY[Index] = static_cast<float>(Location.Y);
+            TargetZ[Index] = static_cast<float>(Location.Z);
+        }
+        else
+        {
+            TargetX[Index] = AISenseBatchedSight::FarAwayCoordinate;
+            TargetY[Index] = AISenseBatchedSight::FarAwayCoordinate;
+            TargetZ[Index] = AISenseBatchedSight::FarAwayCoordinate;
+        }
+    }
+}
+
+void UAISense_BatchedSight::CollectTraceResults(UWorld& World)
+{
+    const double Now = World.GetTimeSeconds();
+
+    for (TPair<FSightPairKey, FSightPair>& Entry : Pairs)
+    {
+        FSightPair& Pair = Entry.Value;
+        if (!Pair.PendingTrace.IsValid())
+        {
+            continue;
+        }
+
+        FTraceDatum TraceData;
+        if (World.QueryTraceData(Pair.PendingTrace, TraceData))
+        {
+            // Listener and target are ignored by the trace, anything blocking it is in the way
+            Pair.bVisible = !TraceData.OutHits.ContainsByPredicate([](const FHitResult& Hit)
+            {
+                return Hit.bBlockingHit;
+            });
+            Pair.TraceTime = Now;
+            Pair.bNewResult = true;
+            Pair.PendingTrace = FTraceHandle();
+        }
+        else if (!World.IsTraceHandleValid(Pair.PendingTrace, false))
+        {
+            // Results are only kept for a frame, the pair is traced again
+            Pair.PendingTrace = FTraceHandle();
+        }
+    }
+}
+
+void UAISense_BatchedSight::GatherCandidates(const FPerceptionListenerID& ListenerId, const FPerceptionListener& Listener, const FDigestedSightProperties& Properties)
+{
+    const FVector3f Location(Listener.CachedLocation);
+    const FVector3f Direction(Listener.CachedDirection);
+
+    const VectorRegister4Float ListenerX = VectorSetFloat1(Location.X);
+    const VectorRegister4Float ListenerY = VectorSetFloat1(Location.Y);
+    const VectorRegister4Float ListenerZ = VectorSetFloat1(Location.Z);
+    const VectorRegister4Float DirectionX = VectorSetFloat1(Direction.X);
+    const VectorRegister4Float DirectionY = VectorSetFloat1(Direction.Y);
+    const VectorRegister4Float DirectionZ = VectorSetFloat1(Direction.Z);
+
+    // The wider lose radius here, targets not seen yet are held to SightRadius below
+    const VectorRegister4Float RadiusSq = VectorSetFloat1(Properties.LoseSightRadiusSq);
+    const VectorRegister4Float ConeCosSq = VectorSetFloat1(FMath::Square(Properties.PeripheralVisionCos));
+    const VectorRegister4Float Zero = VectorZeroFloat();
+    const bool bWideCone = Properties.PeripheralVisionCos < 0.0f;
+
+    const AActor* Body = Listener.GetBodyActor();
+    const bool bSensesAllTeams = (Properties.AffiliationFlags & AISenseBatchedSight::AllAffiliationFlags) == AISenseBatchedSight::AllAffiliationFlags;
+
+    for (int32 Lane = 0; Lane < TargetX.Num(); Lane += 4)
+    {
+        const VectorRegister4Float DeltaX = VectorSubtract(VectorLoad(&TargetX[Lane]), ListenerX);
+        const VectorRegister4Float DeltaY = VectorSubtract(VectorLoad(&TargetY[Lane]), ListenerY);
+        const VectorRegister4Float DeltaZ = VectorSubtract(VectorLoad(&TargetZ[Lane]), ListenerZ);
+
+        const VectorRegister4Float DistSq = VectorMultiplyAdd(DeltaZ, DeltaZ, VectorMultiplyAdd(DeltaY, DeltaY, VectorMultiply(DeltaX, DeltaX)));
+        const VectorRegister4Float Dot = VectorMultiplyAdd(DeltaZ, DirectionZ, VectorMultiplyAdd(DeltaY, DirectionY, VectorMultiply(DeltaX, DirectionX)));
+
+        // Dot >= Cos * Dist without a square root, by comparing squares on the side of the cone's sign
+        const VectorRegister4Float InFront = VectorCompareGE(Dot, Zero);
+        const VectorRegister4Float DotSq = VectorMultiply(Dot, Dot);
+        const VectorRegister4Float ConeDistSq = VectorMultiply(ConeCosSq, DistSq);
+        const VectorRegister4Float InCone = bWideCone
+            ? VectorBitwiseOr(InFront, VectorCompareLE(DotSq, ConeDistSq))
+            : VectorBitwiseAnd(InFront, VectorCompareGE(DotSq, ConeDistSq));
+
+        uint32 Mask = static_cast<uint32>(VectorMaskBits(VectorBitwiseAnd(VectorCompareLE(DistSq, RadiusSq), InCone)));
+        while (Mask != 0)
+        {
+            const int32 TargetIndex = Lane + static_cast<int32>(FMath::CountTrailingZeros(Mask));
+            Mask &= Mask - 1;
+
+            AActor* Target = Targets[TargetIndex].Get();
+            if (!Target || Target == Body)
+            {
+                continue;
+            }
+
+            const FSightPairKey PairKey(ListenerId, TargetIndex);
+            FSightPair* Pair = Pairs.Find(PairKey);
+
+            if (!Pair || !Pair->bReportedVisible)
+            {
+                const float TargetDistSq = FMath::Square(TargetX[TargetIndex] - Location.X)
+                    + FMath::Square(TargetY[TargetIndex] - Location.Y)
+                    + FMath::Square(TargetZ[TargetIndex] - Location.Z);
+                if (TargetDistSq > Properties.SightRadiusSq)
+                {
+                    continue;
+                }
+            }
+
+            if (!bSensesAllTeams)
+            {
+                const ETeamAttitude::Type Attitude = FGenericTeamId::GetAttitude(Listener.TeamIdentifier, FGenericTeamId::GetTeamIdentifier(Target));
+                if ((Properties.AffiliationFlags & (1 << Attitude)) == 0)
+                {
+                    continue;
+                }
+            }
+
+            if (!Pair)
+            {
+                Pair = &Pairs.Add(PairKey);
+                Pair->ListenerId = ListenerId;
+                Pair->TargetIndex = TargetIndex;
+            }
+            Pair->LastCandidateUpdate = UpdateCounter;
+            CandidatePairs.Add(PairKey);
+        }
+    }
+}
+
+void UAISense_BatchedSight::StartTrace(UWorld& World, const FPerceptionListener& Listener, const AActor& Target, FSightPair& Pair)
+{
+    FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(MPAIBatchedSight), true, Listener.GetBodyActor());
+    QueryParams.AddIgnoredActor(&Target);
+
+    Pair.PendingTrace = World.AsyncLineTraceByChannel(EAsyncTraceType::Single,
+        Listener.CachedLocation,
+        Target.GetActorLocation(),
+        SightTraceChannel,
+        QueryParams);
+}
+
+void UAISense_BatchedSight::ReportStimulus(FPerceptionListener& Listener, AActor& Target, bool bVisible)
+{
+    Listener.RegisterStimulus(&Target, FAIStimulus(*this, bVisible ? 1.0f : 0.0f, Target.GetActorLocation(), Listener.CachedLocation,
+        bVisible ? FAIStimulus::SensingSucceeded : FAIStimulus::SensingFailed));
+}
@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Spawner/AIAgentStateArray.h"
+#include "Spawner/AIAgentStateReplicator.h"
+#include "GameFramework/Character.h"
+
+void FAIAgentStateItem::PostReplicatedAdd(const FAIAgentStateArray& InArray)
+{
+    InArray.bItemIndicesDirty = true;
+    if (InArray.OwnerReplicator)
+    {
+        InArray.OwnerReplicator->HandleAgentStateReplicated(*this);
+    }
+}
+
+void FAIAgentStateItem::PostReplicatedChange(const FAIAgentStateArray& InArray)
+{
+    // Also called once a late Agent reference gets resolved
+    InArray.bItemIndicesDirty = true;
+    if (InArray.OwnerReplicator)
+    {
+        InArray.OwnerReplicator->HandleAgentStateReplicated(*this);
+    }
+}
+
+void FAIAgentStateItem::PreReplicatedRemove(const FAIAgentStateArray& InArray)
+{
+    InArray.bItemIndicesDirty = true;
+    if (InArray.OwnerReplicator)
+    {
+        InArray.OwnerReplicator->HandleAgentStateRemoved(*this);
+    }
+}
+
+uint8 FAIAgentStateArray::QuantizeHealth(float CurrentHealth, float MaxHealth)
+{
+    if (MaxHealth <= 0.0f)
+    {
+        return 0;
+    }
+
+    // Anything alive keeps at least one step so a bar never reads empty before the death arrives
+    const uint8 Quantized = static_cast<uint8>(FMath::RoundToInt(FMath::Clamp(CurrentHealth / MaxHealth, 0.0f, 1.0f) * 255.0f));
+    return CurrentHealth > 0.0f ? FMath::Max<uint8>(Quantized, 1) : 0;
+}
+
+void FAIAgentStateArray::SetAgent(ACharacter* Agent, uint8 State, uint8 QuantizedHealth)
+{
+    FAIAgentStateItem* Item = const_cast<FAIAgentStateItem*>(FindAgent(Agent));
+    if (!Item)
+    {
+        ItemIndices.Add(Agent, Items.Num());
+
+        Item = &Items.AddDefaulted_GetRef();
+        Item->Agent = Agent;
+        Item->State = State;
+        Item->QuantizedHealth = QuantizedHealth;
+        MarkItemDirty(*Item);
+        return;
+    }
+
+    // Sub-step health changes cost nothing on the wire
+    if (Item->State != State || Item->QuantizedHealth != QuantizedHealth)
+    {
+        Item->State = State;
+        Item->QuantizedHealth = QuantizedHealth;
+        MarkItemDirty(*Item);
+    }
+}
+
+void FAIAgentStateArray::RemoveAgent(const ACharacter* Agent)
+{
+    if (!FindAgent(Agent))
+    {
+        return;
+    }
+
+    RemoveItemAt(ItemIndices.FindChecked(Agent));
+}
+
+void FAIAgentStateArray::RemoveInvalidAgents()
+{
+    // Backwards, removing swaps the last item into the hole. By index, a collected agent no longer finds its item
+    for (int32 Index = Items.Num() - 1; Index >= 0; --Index)
+    {
+        if (!IsValid(Items[Index].Agent))
+        {
+            RemoveItemAt(Index);
+        }
+    }
+}
+
+void FAIAgentStateArray::RemoveItemAt(int32 Index)
+{
+    // A collected agent left a stale key behind, rebuilt on the next lookup
+    if (const ACharacter* Agent = Items[Index].Agent)
+    {
+        ItemIndices.Remove(Agent);
+    }
+    else
+    {
+        bItemIndicesDirty = true;
+    }
+
+    Items.RemoveAtSwap(Index, 1, false);
+    if (Items.IsValidIndex(Index) && Items[Index].Agent)
+    {
+        ItemIndices.Add(Items[Index].Agent.Get(), Index);
+    }
+    MarkArrayDirty();
+}
+
+const FAIAgentStateItem* FAIAgentStateArray::FindAgent(const ACharacter* Agent) const
+{
+    if (!Agent)
+    {
+        return nullptr;
+    }
+
+    if (bItemIndicesDirty)
+    {
+        bItemIndicesDirty = false;
+        ItemIndices.Reset();
+        for (int32 Index = 0; Index < Items.Num(); ++Index)
+        {
+            if (Items[Index].Agent)
+            {
+                ItemIndices.Add(Items[Index].Agent.Get(), Index);
+            }
+        }
+    }
+
+    const int32* Index = ItemIndices.Find(Agent);
+    return Index && Items.IsValidIndex(*Index) && Items[*Index].Agent == Agent ? &Items[*Index] : nullptr;
+}
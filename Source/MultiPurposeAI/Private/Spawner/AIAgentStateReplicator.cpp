@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Spawner/AIAgentStateReplicator.h"
+#include "Spawner/EnemySpawner.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "Net/UnrealNetwork.h"
+
+AAIAgentStateReplicator::AAIAgentStateReplicator()
+{
+    PrimaryActorTick.bCanEverTick = false;
+
+    // Sent to the owning player only, at the rate the spawner refreshes the states
+    bReplicates = true;
+    bOnlyRelevantToOwner = true;
+    bAlwaysRelevant = false;
+    NetUpdateFrequency = 10.0f;
+    AgentStates.OwnerReplicator = this;
+}
+
+void AAIAgentStateReplicator::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+    Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+    DOREPLIFETIME(AAIAgentStateReplicator, Spawner);
+    DOREPLIFETIME(AAIAgentStateReplicator, AgentStates);
+}
+
+void AAIAgentStateReplicator::Initialize(AEnemySpawner* InSpawner)
+{
+    Spawner = InSpawner;
+    NetUpdateFrequency = 1.0f / FMath::Max(InSpawner->ReplicationUpdateInterval, 0.01f);
+}
+
+void AAIAgentStateReplicator::UpdateAgentStates(const FAIAgentStateArray& ServerStates)
+{
+    const APlayerController* Viewer = Cast<APlayerController>(GetOwner());
+    if (!Viewer)
+    {
+        return;
+    }
+
+    FVector ViewLocation;
+    FRotator ViewRotation;
+    Viewer->GetPlayerViewPoint(ViewLocation, ViewRotation);
+    const AActor* ViewTarget = Viewer->GetViewTarget() ? Viewer->GetViewTarget() : Viewer;
+
+    // Same test the net driver runs on the character itself, so the Agent reference of every item sent resolves
+    auto IsRelevant = [Viewer, ViewTarget, &ViewLocation](const ACharacter* Agent)
+    {
+        return Agent && Agent->IsNetRelevantFor(Viewer, ViewTarget, ViewLocation);
+    };
+
+    // Agents destroyed behind the spawner's back first, they can no longer be removed by reference
+    AgentStates.RemoveInvalidAgents();
+
+    // Backwards, removing swaps the last item into the hole
+    for (int32 Index = AgentStates.Items.Num() - 1; Index >= 0; --Index)
+    {
+        const ACharacter* Agent = AgentStates.Items[Index].Agent;
+        if (!IsRelevant(Agent))
+        {
+            AgentStates.RemoveAgent(Agent);
+        }
+    }
+
+    for (const FAIAgentStateItem& Item : ServerStates.Items)
+    {
+        if (IsRelevant(Item.Agent))
+        {
+            AgentStates.SetAgent(Item.Agent, Item.State, Item.QuantizedHealth);
+        }
+    }
+}
+
+void AAIAgentStateReplicator::RemoveAgent(const ACharacter* Agent)
+{
+    AgentStates.RemoveAgent(Agent);
+}
+
+void AAIAgentStateReplicator::HandleAgentStateReplicated(const FAIAgentStateItem& Item)
+{
+    // Agent stays null until the character itself reached this client
+    if (!Spawner)
+    {
+        bMissedAgentStates = true;
+    }
+    else if (Item.Agent)
+    {
+        Spawner->OnAgentStateReplicated.Broadcast(Item.Agent, static_cast<EAICharacterState>(Item.State), Item.GetHealthFraction());
+    }
+}
+
+void AAIAgentStateReplicator::HandleAgentStateRemoved(const FAIAgentStateItem& Item)
+{
+    if (Spawner && Item.Agent)
+    {
+        Spawner->OnAgentStateRemoved.Broadcast(Item.Agent);
+    }
+}
+
+void AAIAgentStateReplicator::OnRep_Spawner()
+{
+    if (!Spawner)
+    {
+        return;
+    }
+
+    Spawner->SetLocalAgentStateReplicator(this);
+
+    // Items that arrived while the spawner reference was still unresolved
+    if (bMissedAgentStates)
+    {
+        bMissedAgentStates = false;
+        for (const FAIAgentStateItem& Item : AgentStates.Items)
+        {
+            HandleAgentStateReplicated(Item);
+        }
+    }
+}
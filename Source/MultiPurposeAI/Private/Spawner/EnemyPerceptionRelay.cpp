@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Spawner/EnemyPerceptionRelay.h"
+#include "Spawner/EnemySpawner.h"
+#include "GameFramework/Character.h"
+
+void UEnemyPerceptionRelay::Initialize(AEnemySpawner* InSpawner, ACharacter* InEnemy)
+{
+    Spawner = InSpawner;
+    Enemy = InEnemy;
+}
+
+void UEnemyPerceptionRelay::OnTargetPerceptionUpdated(AActor* Actor, FAIStimulus Stimulus)
+{
+    AEnemySpawner* OwningSpawner = Spawner.Get();
+    ACharacter* PerceivingEnemy = Enemy.Get();
+    if (OwningSpawner && PerceivingEnemy)
+    {
+        OwningSpawner->HandleTargetPerceptionUpdated(PerceivingEnemy, Actor, Stimulus);
+    }
+}
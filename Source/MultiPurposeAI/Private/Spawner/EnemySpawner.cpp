@@ -2,17 +2,45 @@
 
 
 #include "Spawner/EnemySpawner.h"
+#include "MultiPurposeAI.h"
+#include "Diagnostics/AIDiagnostics.h"
+#include "Diagnostics/AIStats.h"
 #include "GameFramework/Character.h"
 #include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
 #include "BehaviorTree/BehaviorTree.h"
 #include "AIController.h"
 #include "Enums.h"
 #include "Components/StateManagerComponent.h"
 #include "Components/DamageableComponent.h"
+#include "Components/ProfiledBehaviorTreeComponent.h"
 #include "Perception/AIPerceptionComponent.h"
 #include "Perception/AISenseConfig.h"
 #include "BehaviorTree/BlackboardComponent.h" 
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Enum.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
 #include "Data/CharacterDataAsset.h"
+#include "Spawner/EnemyPerceptionRelay.h"
+#include "Spawner/EnemySpawnerSnapshot.h"
+#include "Spawner/AIAgentStateReplicator.h"
+#include "Subsystems/AlertPropagationSubsystem.h"
+#include "Subsystems/DamageQueueSubsystem.h"
+#include "Subsystems/AILODSubsystem.h"
+#include "Subsystems/AICrowdSubsystem.h"
+#include "Subsystems/BlackboardWriteSubsystem.h"
+#include "Diagnostics/AIBehaviorTreeProfiler.h"
+#include "Engine/AssetManager.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "BrainComponent.h"
+#include "Perception/AIPerceptionSystem.h"
+#include "Perception/AISense.h"
+#include "TimerManager.h"
+#include "Components/CapsuleComponent.h"
+#include "NavigationSystem.h"
+#include "NavigationData.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "WorldPartition/WorldPartitionSubsystem.h"
 
 // Constructor implementation
 AEnemySpawner::AEnemySpawner()
@@ -20,156 +48,1752 @@ AEnemySpawner::AEnemySpawner()
     // Default values, can be changed in the editor or on spawn
     DefaultSkeletalMesh = nullptr;
     DefaultAnimBlueprint = nullptr;
+
+    // Only ticks while the spawn queue has work
+    PrimaryActorTick.bCanEverTick = true;
+    PrimaryActorTick.bStartWithTickEnabled = false;
+
+    // Carries no properties, replicated and relevant everywhere only so the agent state replicators can refer to
+    // spawners spawned at runtime too. Initial dormancy only holds for spawners placed in the level, the ones spawned
+    // at runtime stay awake and cost the net driver a relevancy and property check per net update
+    bReplicates = true;
+    bAlwaysRelevant = true;
+    NetDormancy = DORM_Initial;
+}
+
+void AEnemySpawner::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    // The characters are torn down with the level, only the stats have to forget them
+    DEC_DWORD_STAT_BY(STAT_MPAI_LiveAgents, SpawnedEnemies.Num());
+    SpawnedEnemies.Reset();
+    for (const TPair<TObjectPtr<UCharacterDataAsset>, FEnemyPool>& Pool : EnemyPools)
+    {
+        DEC_DWORD_STAT_BY(STAT_MPAI_PooledAgents, Pool.Value.DormantEnemies.Num());
+    }
+
+    if (DamageQueue)
+    {
+        DamageQueue->OnAgentsDied.Remove(AgentsDiedHandle);
+        DamageQueue = nullptr;
+    }
+
+    if (CrowdSubsystem)
+    {
+        CrowdSubsystem->DestroyEntities(this);
+        CrowdSubsystem = nullptr;
+    }
+
+    for (AAIAgentStateReplicator* Replicator : AgentStateReplicators)
+    {
+        if (IsValid(Replicator))
+        {
+            Replicator->Destroy();
+        }
+    }
+    AgentStateReplicators.Reset();
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void AEnemySpawner::BeginPlay()
+{
+    Super::BeginPlay();
+
+    // The server spawns the enemies, clients get the characters and their player's agent states replicated
+    if (!HasAuthority())
+    {
+        return;
+    }
+
+    if (bReplicateAgentStates && GetNetMode() != NM_Standalone)
+    {
+        GetWorldTimerManager().SetTimer(ReplicationTimerHandle, this, &AEnemySpawner::UpdateReplicatedAgentStates, ReplicationUpdateInterval, true);
+    }
+
+    AlertSubsystem = GetWorld()->GetSubsystem<UAlertPropagationSubsystem>();
+    LODSubsystem = GetWorld()->GetSubsystem<UAILODSubsystem>();
+    CrowdSubsystem = GetWorld()->GetSubsystem<UAICrowdSubsystem>();
+    BlackboardWriter = GetWorld()->GetSubsystem<UBlackboardWriteSubsystem>();
+
+    // Enemies on the damage queue report their deaths once per frame, in one batch
+    DamageQueue = GetWorld()->GetSubsystem<UDamageQueueSubsystem>();
+    if (DamageQueue)
+    {
+        AgentsDiedHandle = DamageQueue->OnAgentsDied.AddUObject(this, &AEnemySpawner::HandleAgentsDied);
+    }
+
+    // Request every archetype up front so the streaming requests are batched together
+    if (bPreloadArchetypes)
+    {
+        for (const FEnemySpawnData& EnemyData : EnemiesToSpawn)
+        {
+            if (EnemyData.EnemyDataAsset)
+            {
+                PreloadArchetype(EnemyData.EnemyDataAsset);
+            }
+        }
+    }
+
+    // The sweeps need the capsule of every archetype, spawning waits for them
+    if (bValidateSpawnPoints)
+    {
+        bSpawnPointValidationPending = true;
+        TryValidateSpawnPoints();
+    }
+    else
+    {
+        StartSpawning();
+    }
+}
+
+void AEnemySpawner::TryValidateSpawnPoints()
+{
+    if (!bSpawnPointValidationPending)
+    {
+        return;
+    }
+
+    if (bPreloadArchetypes)
+    {
+        for (const FEnemySpawnData& EnemyData : EnemiesToSpawn)
+        {
+            if (EnemyData.EnemyDataAsset && !IsArchetypeResident(EnemyData.EnemyDataAsset))
+            {
+                return;
+            }
+        }
+    }
+
+    bSpawnPointValidationPending = false;
+    ValidateSpawnPoints();
+
+    if (NumPendingSpawnPointSweeps == 0)
+    {
+        StartSpawning();
+    }
+}
+
+void AEnemySpawner::StartSpawning()
+{
+    TSet<UCharacterDataAsset*> Archetypes;
+    for (const FEnemySpawnData& EnemyData : EnemiesToSpawn)
+    {
+        if (EnemyData.EnemyDataAsset)
+        {
+            Archetypes.Add(EnemyData.EnemyDataAsset);
+        }
+    }
+
+    // Crowd entries only become characters near a player, streamed entries once a source comes close to their cell
+    if (bSpawnAsCrowd && CrowdSubsystem)
+    {
+        CrowdSubsystem->SpawnEntities(this, EnemiesToSpawn);
+    }
+    else if (bUseProximityStreaming)
+    {
+        BuildStreamingCells();
+        GetWorldTimerManager().SetTimer(StreamingTimerHandle, this, &AEnemySpawner::UpdateStreaming, StreamingUpdateInterval, true);
+        UpdateStreaming();
+    }
+    else
+    {
+        for (const FEnemySpawnData& EnemyData : EnemiesToSpawn)
+        {
+            QueueEnemySpawn(EnemyData);
+        }
+    }
+
+    // Fill the pools after the initial wave so the dormant reserve is still there for respawns
+    if (bUsePooling)
+    {
+        for (UCharacterDataAsset* Archetype : Archetypes)
+        {
+            QueuePoolPrewarm(Archetype, Archetype->PoolPrewarmCount);
+        }
+    }
+
+    if (!bTimeSliceSpawning)
+    {
+        FlushSpawnQueue();
+    }
+}
+
+void AEnemySpawner::Tick(float DeltaSeconds)
+{
+    Super::Tick(DeltaSeconds);
+
+    ProcessSpawnQueue(SpawnBudgetMs / 1000.0);
+    FlushPerceptionRegistrations();
+    ProcessCorpses();
+    UpdateTickEnabled();
+}
+
+void AEnemySpawner::UpdateTickEnabled()
+{
+    SetActorTickEnabled(SpawnQueue.Num() > 0 || Corpses.Num() > 0 || PendingPerceptionRegistrations.Num() > 0);
+}
+
+void AEnemySpawner::PreloadArchetype(UCharacterDataAsset* CharacterDataAsset)
+{
+    if (!CharacterDataAsset || ArchetypePreloads.Contains(CharacterDataAsset))
+    {
+        return;
+    }
+
+    TArray<FSoftObjectPath> AssetsToLoad;
+    CharacterDataAsset->GetAssetsToPreload(AssetsToLoad);
+
+    FArchetypePreload& Preload = ArchetypePreloads.Add(CharacterDataAsset);
+    Preload.RequestTime = FPlatformTime::Seconds();
+
+    if (AssetsToLoad.Num() == 0)
+    {
+        HandleArchetypePreloaded(CharacterDataAsset);
+        return;
+    }
+
+    // The delegate fires right away when everything is already in memory
+    Preload.Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+        AssetsToLoad,
+        FStreamableDelegate::CreateUObject(this, &AEnemySpawner::HandleArchetypePreloaded, CharacterDataAsset),
+        FStreamableManager::AsyncLoadHighPriority);
+}
+
+bool AEnemySpawner::IsArchetypeResident(const UCharacterDataAsset* CharacterDataAsset) const
+{
+    const FArchetypePreload* Preload = ArchetypePreloads.Find(CharacterDataAsset);
+    return Preload && Preload->bLoaded;
+}
+
+float AEnemySpawner::GetArchetypeLoadLatencyMs(const UCharacterDataAsset* CharacterDataAsset) const
+{
+    const FArchetypePreload* Preload = ArchetypePreloads.Find(CharacterDataAsset);
+    return Preload ? Preload->LoadLatencyMs : -1.0f;
+}
+
+void AEnemySpawner::HandleArchetypePreloaded(UCharacterDataAsset* CharacterDataAsset)
+{
+    FArchetypePreload* Preload = ArchetypePreloads.Find(CharacterDataAsset);
+    if (!Preload || Preload->bLoaded)
+    {
+        return;
+    }
+
+    Preload->bLoaded = true;
+    Preload->LoadLatencyMs = static_cast<float>((FPlatformTime::Seconds() - Preload->RequestTime) * 1000.0);
+
+    UE_LOG(LogMultiPurposeAI, Verbose, TEXT("Archetype %s resident after %.2f ms"), *GetNameSafe(CharacterDataAsset), Preload->LoadLatencyMs);
+
+    if (Preload->WaitingSpawns.Num() > 0)
+    {
+        NumSpawnsWaitingForLoad -= Preload->WaitingSpawns.Num();
+        SpawnQueue.Append(MoveTemp(Preload->WaitingSpawns));
+        Preload->WaitingSpawns.Reset();
+
+        bSpawnQueueNeedsSort = true;
+        SetActorTickEnabled(true);
+    }
+
+    // Resolve blackboard keys and classes now rather than on the first spawn
+    CharacterDataAsset->GetCompiledArchetype();
+
+    OnArchetypeLoaded.Broadcast(CharacterDataAsset, Preload->LoadLatencyMs);
+
+    // The spawn point validation or a snapshot restore may have been waiting for this archetype
+    TryValidateSpawnPoints();
+    TryApplyPendingSnapshot();
+}
+
+void AEnemySpawner::QueueEnemySpawn(const FEnemySpawnData& EnemyData)
+{
+    FPendingEnemySpawn Pending;
+    Pending.SpawnData = EnemyData;
+    Pending.Priority = static_cast<float>(SpawnQueueSequence++);
+
+    EnqueuePendingSpawn(Pending);
+}
+
+void AEnemySpawner::QueuePoolPrewarm(UCharacterDataAsset* CharacterDataAsset, int32 Count)
+{
+    if (!CharacterDataAsset)
+    {
+        return;
+    }
+
+    FPendingEnemySpawn Pending;
+    Pending.SpawnData.EnemyDataAsset = CharacterDataAsset;
+    Pending.Priority = TNumericLimits<float>::Max();
+    Pending.bPrewarmOnly = true;
+
+    for (int32 Index = 0; Index < Count; ++Index)
+    {
+        EnqueuePendingSpawn(Pending);
+    }
+}
+
+void AEnemySpawner::EnqueuePendingSpawn(const FPendingEnemySpawn& Pending)
+{
+    UCharacterDataAsset* Archetype = Pending.SpawnData.EnemyDataAsset;
+    if (bPreloadArchetypes && Archetype && !IsArchetypeResident(Archetype))
+    {
+        PreloadArchetype(Archetype);
+
+        // Still streaming, the entry joins the queue once the archetype is resident
+        if (!IsArchetypeResident(Archetype))
+        {
+            ArchetypePreloads.FindChecked(Archetype).WaitingSpawns.Add(Pending);
+            ++NumSpawnsWaitingForLoad;
+            return;
+        }
+    }
+
+    SpawnQueue.Add(Pending);
+    bSpawnQueueNeedsSort = true;
+    SetActorTickEnabled(true);
+}
+
+void AEnemySpawner::FlushSpawnQueue()
+{
+    // Block on whatever is still streaming so every entry can be spawned now
+    for (TPair<TObjectPtr<UCharacterDataAsset>, FArchetypePreload>& Pair : ArchetypePreloads)
+    {
+        if (!Pair.Value.bLoaded && Pair.Value.Handle.IsValid())
+        {
+            Pair.Value.Handle->WaitUntilComplete();
+        }
+    }
+
+    ProcessSpawnQueue(TNumericLimits<double>::Max());
+}
+
+float AEnemySpawner::GetSpawnQueueProgress() const
+{
+    const int32 Total = SpawnQueueProcessed + SpawnQueue.Num() + NumSpawnsWaitingForLoad;
+    return Total > 0 ? static_cast<float>(SpawnQueueProcessed) / Total : 1.0f;
+}
+
+void AEnemySpawner::ProcessSpawnQueue(double BudgetSeconds)
+{
+    if (SpawnQueue.Num() == 0)
+    {
+        UpdateTickEnabled();
+        return;
+    }
+
+    // Players move while the queue drains, distance priorities follow them once one moved far enough
+    if (bPrioritizeByPlayerDistance)
+    {
+        RescoreSpawnQueue();
+    }
+    if (bSpawnQueueNeedsSort)
+    {
+        SortSpawnQueue();
+    }
+
+    // The whole slice joins the perception system at once, after the loop
+    TGuardValue<bool> SpawnBatchGuard(bInSpawnBatch, true);
+
+    const double StartTime = FPlatformTime::Seconds();
+    do
+    {
+        const FPendingEnemySpawn Pending = SpawnQueue.Pop(false);
+        if (Pending.bPrewarmOnly)
+        {
+            CreateDormantEnemy(Pending.SpawnData.EnemyDataAsset);
+        }
+        else if (Pending.StreamingEntry != INDEX_NONE)
+        {
+            SpawnStreamedEnemy(Pending.StreamingEntry);
+        }
+        else
+        {
+            SpawnEnemy(Pending.SpawnData);
+        }
+        ++SpawnQueueProcessed;
+    }
+    while (SpawnQueue.Num() > 0 && FPlatformTime::Seconds() - StartTime < BudgetSeconds);
+
+    FlushPerceptionRegistrations();
+
+    OnSpawnQueueProgress.Broadcast(SpawnQueueProcessed, SpawnQueueProcessed + SpawnQueue.Num() + NumSpawnsWaitingForLoad);
+
+    if (SpawnQueue.Num() == 0)
+    {
+        // Ticking resumes when a streaming archetype releases its waiting spawns
+        UpdateTickEnabled();
+
+        if (NumSpawnsWaitingForLoad == 0)
+        {
+            SpawnQueueProcessed = 0;
+            OnSpawnQueueCompleted.Broadcast();
+        }
+    }
+}
+
+void AEnemySpawner::RescoreSpawnQueue()
+{
+    TArray<FVector, TInlineAllocator<4>> PlayerLocations;
+    for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+    {
+        const APlayerController* PlayerController = It->Get();
+        const APawn* PlayerPawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+        if (PlayerPawn)
+        {
+            PlayerLocations.Add(PlayerPawn->GetActorLocation());
+        }
+    }
+
+    // Without a player to measure from the entries keep the priority they were queued with
+    if (PlayerLocations.Num() == 0)
+    {
+        return;
+    }
+
+    // New entries still carry their queue sequence number, so they always trigger a pass
+    bool bPlayersMoved = bSpawnQueueNeedsSort || PlayerLocations.Num() != ScoredPlayerLocations.Num();
+    const double RescoreDistanceSquared = FMath::Square(SpawnQueueRescoreDistance);
+    for (int32 Index = 0; !bPlayersMoved && Index < PlayerLocations.Num(); ++Index)
+    {
+        bPlayersMoved = FVector::DistSquared(PlayerLocations[Index], ScoredPlayerLocations[Index]) > RescoreDistanceSquared;
+    }
+
+    if (!bPlayersMoved)
+    {
+        return;
+    }
+
+    ScoredPlayerLocations = PlayerLocations;
+    for (FPendingEnemySpawn& Pending : SpawnQueue)
+    {
+        if (Pending.bPrewarmOnly)
+        {
+            continue;
+        }
+
+        float ClosestDistanceSquared = TNumericLimits<float>::Max();
+        for (const FVector& PlayerLocation : PlayerLocations)
+        {
+            const float DistanceSquared = FVector::DistSquared(PlayerLocation, Pending.SpawnData.SpawnTransform.GetLocation());
+            ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, DistanceSquared);
+        }
+        Pending.Priority = ClosestDistanceSquared;
+    }
+    bSpawnQueueNeedsSort = true;
+}
+
+void AEnemySpawner::SortSpawnQueue()
+{
+    bSpawnQueueNeedsSort = false;
+
+    // Highest priority last so Pop() takes it, stable so prewarm entries and equal distances keep their queue order
+    SpawnQueue.StableSort([](const FPendingEnemySpawn& A, const FPendingEnemySpawn& B)
+    {
+        return A.Priority > B.Priority;
+    });
+}
+
+// Function to spawn an enemy and assign assets based on the data asset provided
+ACharacter* AEnemySpawner::SpawnEnemy(const FEnemySpawnData& EnemyData)
+{
+    MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_SpawnEnemy);
+
+    if (!EnemyData.EnemyDataAsset)
+    {
+        UE_LOG(LogMultiPurposeAI, Warning, TEXT("Enemy data asset is null! Skipping spawn."));
+        return nullptr;
+    }
+
+    ACharacter* SpawnedCharacter = nullptr;
+    if (bUsePooling)
+    {
+        SpawnedCharacter = AcquireEnemy(EnemyData.EnemyDataAsset, EnemyData.SpawnTransform, EnemyData.SquadId);
+    }
+    else
+    {
+        SpawnedCharacter = CreateEnemy(EnemyData.EnemyDataAsset, EnemyData.SpawnTransform);
+        if (SpawnedCharacter)
+        {
+            SpawnedEnemies.Add(SpawnedCharacter);
+            INC_DWORD_STAT(STAT_MPAI_LiveAgents);
+
+            FSpawnedEnemyRecord& Record = EnemyRecords.FindChecked(SpawnedCharacter);
+            Record.SquadId = EnemyData.SquadId;
+            RegisterAlertAgent(SpawnedCharacter, Record);
+        }
+    }
+
+    // A single spawn perceives right away, a batch registers its listeners together once it is done
+    if (!bInSpawnBatch)
+    {
+        FlushPerceptionRegistrations();
+    }
+
+    return SpawnedCharacter;
+}
+
+ACharacter* AEnemySpawner::CreateEnemy(UCharacterDataAsset* CharacterDataAsset, const FTransform& SpawnTransform)
+{
+    UWorld* World = GetWorld();
+    if (!World || !CharacterDataAsset)
+    {
+        return nullptr;
+    }
+
+    // Pooled characters are pre-warmed on top of each other, they get moved when acquired
+    FActorSpawnParameters SpawnParams;
+    SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+    // Spawn the enemy
+    ACharacter* SpawnedCharacter = World->SpawnActor<ACharacter>(
+        CharacterDataAsset->GetCompiledArchetype().CharacterClass, 
+        SpawnTransform,
+        SpawnParams);
+
+    if (!SpawnedCharacter)
+    {
+        return nullptr;
+    }
+
+    MPAI_COUNT(EnemiesCreated);
+
+    AAIController* AIController = Cast<AAIController>(SpawnedCharacter->GetController());
+
+    // If the character doesn't have a controller, create one
+    if (!AIController)
+    {
+        // Spawn the default AI controller for the character
+        SpawnedCharacter->SpawnDefaultController();
+
+        // Get the newly created controller
+        AIController = Cast<AAIController>(SpawnedCharacter->GetController());
+    }
+
+    FSpawnedEnemyRecord& Record = EnemyRecords.Add(SpawnedCharacter);
+    Record.DataAsset = CharacterDataAsset;
+    Record.Controller = AIController;
+
+    // Initialize the enemy with the assigned AIController
+    if (AIController)
+    {
+        InitializeEnemy(SpawnedCharacter, CharacterDataAsset, AIController); 
+        AssignAIPerceptionConfig(SpawnedCharacter, CharacterDataAsset, AIController);
+    }
+    else
+    {
+        // InitializeEnemy caches it otherwise
+        CacheEnemyRecord(SpawnedCharacter, Record);
+    }
+
+    return SpawnedCharacter;
+}
+
+void AEnemySpawner::RegisterAlertAgent(ACharacter* Enemy, const FSpawnedEnemyRecord& Record)
+{
+    if (AlertSubsystem && Record.DataAsset)
+    {
+        AlertSubsystem->RegisterAgent(Enemy, Record.StateManager, Record.DataAsset->DetectionState, this, Record.SquadId);
+    }
+
+    // Live enemies of archetypes with LOD tiers get cheaper with distance
+    if (LODSubsystem)
+    {
+        LODSubsystem->RegisterAgent(Enemy, Record.Controller, Record.DataAsset);
+    }
+}
+
+void AEnemySpawner::CacheEnemyRecord(ACharacter* Enemy, FSpawnedEnemyRecord& Record)
+{
+    Record.bComponentsCached = true;
+    Record.StateManager = Enemy->GetComponentByClass<UStateManagerComponent>();
+    if (Record.StateManager)
+    {
+        Record.StateManager->SetTransitionTable(Record.DataAsset);
+    }
+    Record.DamageComponent = Enemy->GetComponentByClass<UDamageableComponent>();
+    Record.Blackboard = Record.Controller ? Record.Controller->GetBlackboardComponent() : nullptr;
+
+    if (Record.Blackboard && Record.DataAsset)
+    {
+        const FCompiledCharacterArchetype& Archetype = Record.DataAsset->GetCompiledArchetype();
+        Record.AIStateKey = Record.Blackboard->GetBlackboardAsset() == Archetype.BlackboardAsset
+            ? Archetype.AIStateKey
+            : Record.Blackboard->GetKeyID(UCharacterDataAsset::AIStateKeyName);
+    }
+
+    // The spawner decides what happens to the body, left as a corpse then pooled or destroyed
+    if (Record.DamageComponent)
+    {
+        Record.DamageComponent->bDestroyOwnerOnDeath = false;
+        Record.DamageComponent->SetUseDamageQueue(bUseDamageQueue);
+        if (!Record.DamageComponent->IsUsingDamageQueue())
+        {
+            Record.DamageComponent->OnDeath.AddUniqueDynamic(this, &AEnemySpawner::OnEnemyDeath);
+        }
+    }
+
+    Enemy->OnDestroyed.AddUniqueDynamic(this, &AEnemySpawner::HandleEnemyDestroyed);
+}
+
+ACharacter* AEnemySpawner::AcquireEnemy(UCharacterDataAsset* CharacterDataAsset, const FTransform& SpawnTransform, int32 SquadId)
+{
+    if (!CharacterDataAsset)
+    {
+        return nullptr;
+    }
+
+    ACharacter* Enemy = nullptr;
+    FEnemyPool* Pool = EnemyPools.Find(CharacterDataAsset);
+    if (Pool)
+    {
+        // Skip characters that were destroyed behind our back while dormant
+        while (!Enemy && Pool->DormantEnemies.Num() > 0)
+        {
+            ACharacter* Candidate = Pool->DormantEnemies.Pop(false);
+            DEC_DWORD_STAT(STAT_MPAI_PooledAgents);
+            if (IsValid(Candidate))
+            {
+                Enemy = Candidate;
+            }
+        }
+    }
+
+    if (Enemy)
+    {
+        ActivateEnemy(Enemy, CharacterDataAsset, SpawnTransform);
+        MPAI_COUNT(EnemiesAcquiredFromPool);
+    }
+    else
+    {
+        Enemy = CreateEnemy(CharacterDataAsset, SpawnTransform);
+    }
+
+    if (Enemy)
+    {
+        SpawnedEnemies.Add(Enemy);
+        INC_DWORD_STAT(STAT_MPAI_LiveAgents);
+
+        FSpawnedEnemyRecord& Record = EnemyRecords.FindChecked(Enemy);
+        Record.SquadId = SquadId;
+        RegisterAlertAgent(Enemy, Record);
+    }
+
+    return Enemy;
+}
+
+void AEnemySpawner::ReleaseEnemy(ACharacter* Enemy)
+{
+    FSpawnedEnemyRecord* Record = EnemyRecords.Find(Enemy);
+    if (!IsValid(Enemy) || !Record)
+    {
+        UE_LOG(LogMultiPurposeAI, Warning, TEXT("ReleaseEnemy called with a character this spawner does not own"));
+        return;
+    }
+
+    // Already dormant
+    if (SpawnedEnemies.Remove(Enemy) == 0)
+    {
+        return;
+    }
+    DEC_DWORD_STAT(STAT_MPAI_LiveAgents);
+
+    // The streaming entry spawns a fresh character when its cell comes back
+    if (Record->StreamingEntry != INDEX_NONE)
+    {
+        StreamedEnemies[Record->StreamingEntry].Enemy = nullptr;
+        Record->StreamingEntry = INDEX_NONE;
+    }
+
+    DeactivateEnemy(Enemy);
+    MPAI_COUNT(EnemiesReleased);
+    EnemyPools.FindOrAdd(Record->DataAsset).DormantEnemies.Add(Enemy);
+    INC_DWORD_STAT(STAT_MPAI_PooledAgents);
+}
+
+void AEnemySpawner::PrewarmPool(UCharacterDataAsset* CharacterDataAsset, int32 Count)
+{
+    if (!CharacterDataAsset)
+    {
+        return;
+    }
+
+    while (EnemyPools.FindOrAdd(CharacterDataAsset).DormantEnemies.Num() < Count)
+    {
+        if (!CreateDormantEnemy(CharacterDataAsset))
+        {
+            break;
+        }
+    }
+}
+
+ACharacter* AEnemySpawner::CreateDormantEnemy(UCharacterDataAsset* CharacterDataAsset)
+{
+    if (!CharacterDataAsset)
+    {
+        return nullptr;
+    }
+
+    ACharacter* Enemy = CreateEnemy(CharacterDataAsset, GetActorTransform());
+    if (Enemy)
+    {
+        DeactivateEnemy(Enemy);
+        EnemyPools.FindOrAdd(CharacterDataAsset).DormantEnemies.Add(Enemy);
+        INC_DWORD_STAT(STAT_MPAI_PooledAgents);
+    }
+
+    return Enemy;
+}
+
+void AEnemySpawner::ActivateEnemy(ACharacter* Enemy, UCharacterDataAsset* CharacterDataAsset, const FTransform& SpawnTransform)
+{
+    Enemy->SetActorLocationAndRotation(SpawnTransform.GetLocation(), SpawnTransform.GetRotation(), false, nullptr, ETeleportType::ResetPhysics);
+    Enemy->SetActorHiddenInGame(false);
+    Enemy->SetActorEnableCollision(true);
+    Enemy->SetActorTickEnabled(true);
+    Enemy->GetMesh()->SetComponentTickEnabled(true);
+
+    UCharacterMovementComponent* Movement = Enemy->GetCharacterMovement();
+    if (Movement)
+    {
+        Movement->SetComponentTickEnabled(true);
+        Movement->SetDefaultMovementMode();
+    }
+
+    AAIController* AIController = Cast<AAIController>(Enemy->GetController());
+    if (AIController)
+    {
+        AIController->SetActorTickEnabled(true);
+
+        // Same setup as a fresh spawn, everything in there skips work that is already done
+        InitializeEnemy(Enemy, CharacterDataAsset, AIController);
+        AssignAIPerceptionConfig(Enemy, CharacterDataAsset, AIController);
+
+        UAIPerceptionComponent* PerceptionComponent = AIController->GetPerceptionComponent();
+        if (PerceptionComponent)
+        {
+            for (const TObjectPtr<UAISenseConfig>& SenseConfig : CharacterDataAsset->GetCompiledArchetype().SenseConfigs)
+            {
+                PerceptionComponent->SetSenseEnabled(SenseConfig->GetSenseImplementation(), true);
+            }
+        }
+    }
+
+    // Let the other agents see this one again, through the senses they actually listen with
+    for (const TSubclassOf<UAISense>& Sense : ListenerSenses)
+    {
+        UAIPerceptionSystem::RegisterPerceptionStimuliSource(this, Sense, Enemy);
+    }
+}
+
+void AEnemySpawner::StopEnemy(ACharacter* Enemy)
+{
+    AAIController* AIController = Cast<AAIController>(Enemy->GetController());
+    if (AIController)
+    {
+        UBrainComponent* BrainComponent = AIController->GetBrainComponent();
+        if (BrainComponent)
+        {
+            BrainComponent->StopLogic(TEXT("Stopped by spawner"));
+        }
+
+        AIController->StopMovement();
+
+        UAIPerceptionComponent* PerceptionComponent = AIController->GetPerceptionComponent();
+        if (PerceptionComponent)
+        {
+            PerceptionComponent->ForgetAll();
+
+            const FSpawnedEnemyRecord* Record = EnemyRecords.Find(Enemy);
+            if (Record && Record->DataAsset)
+            {
+                for (const TObjectPtr<UAISenseConfig>& SenseConfig : Record->DataAsset->GetCompiledArchetype().SenseConfigs)
+                {
+                    PerceptionComponent->SetSenseEnabled(SenseConfig->GetSenseImplementation(), false);
+                }
+            }
+        }
+
+        AIController->SetActorTickEnabled(false);
+    }
+
+    if (AlertSubsystem)
+    {
+        AlertSubsystem->UnregisterAgent(Enemy);
+    }
+    if (LODSubsystem)
+    {
+        LODSubsystem->UnregisterAgent(Enemy);
+    }
+    RemoveReplicatedAgent(Enemy);
+
+    // Dead and dormant characters don't count towards any state
+    const FSpawnedEnemyRecord* EnemyRecord = EnemyRecords.Find(Enemy);
+    if (EnemyRecord && EnemyRecord->StateManager)
+    {
+        EnemyRecord->StateManager->SetCurrentState(EAICharacterState::None);
+    }
+
+    // Dead and dormant characters must not be perceived by the active ones
+    UAIPerceptionSystem* PerceptionSystem = UAIPerceptionSystem::GetCurrent(GetWorld());
+    if (PerceptionSystem)
+    {
+        PerceptionSystem->UnregisterSource(*Enemy);
+    }
+
+    UCharacterMovementComponent* Movement = Enemy->GetCharacterMovement();
+    if (Movement)
+    {
+        Movement->StopMovementImmediately();
+        Movement->DisableMovement();
+        Movement->SetComponentTickEnabled(false);
+    }
+
+    // The mesh keeps ticking so a death animation can play out
+    Enemy->SetActorTickEnabled(false);
+}
+
+void AEnemySpawner::DeactivateEnemy(ACharacter* Enemy)
+{
+    StopEnemy(Enemy);
+
+    Enemy->GetMesh()->SetComponentTickEnabled(false);
+    Enemy->SetActorHiddenInGame(true);
+    Enemy->SetActorEnableCollision(false);
+}
+
+void AEnemySpawner::HandleAgentsDied(const TArray<AActor*>& DeadActors)
+{
+    for (AActor* DeadActor : DeadActors)
+    {
+        // Every spawner hears about every death, only handle ours
+        if (EnemyRecords.Contains(Cast<ACharacter>(DeadActor)))
+        {
+            OnEnemyDeath(DeadActor);
+        }
+    }
+}
+
+void AEnemySpawner::OnEnemyDeath(AActor* DeadActor)
+{
+    ACharacter* Enemy = Cast<ACharacter>(DeadActor);
+    FSpawnedEnemyRecord* Record = EnemyRecords.Find(Enemy);
+    if (!Record || SpawnedEnemies.Remove(Enemy) == 0)
+    {
+        return;
+    }
+    DEC_DWORD_STAT(STAT_MPAI_LiveAgents);
+
+    // A promoted crowd enemy takes its entity with it
+    if (CrowdSubsystem)
+    {
+        CrowdSubsystem->HandlePromotedEnemyDied(Enemy);
+    }
+
+    // Killed enemies stay dead when their cell streams back in
+    if (Record->StreamingEntry != INDEX_NONE)
+    {
+        FStreamedEnemyState& Entry = StreamedEnemies[Record->StreamingEntry];
+        Entry.Enemy = nullptr;
+        Entry.bDead = true;
+        Record->StreamingEntry = INDEX_NONE;
+    }
+
+    // Everything that costs time stops now, the actor itself is only touched once the corpse expires
+    StopEnemy(Enemy);
+
+    const float CorpseLifetime = Record->DataAsset ? Record->DataAsset->CorpseLifetime : 0.0f;
+    FEnemyCorpse Corpse;
+    Corpse.Enemy = Enemy;
+    Corpse.RecycleTime = GetWorld()->GetTimeSeconds() + CorpseLifetime;
+    Corpses.HeapPush(Corpse);
+    UpdateTickEnabled();
+}
+
+void AEnemySpawner::ProcessCorpses()
+{
+    const double Now = GetWorld()->GetTimeSeconds();
+
+    int32 NumRecycled = 0;
+    while (Corpses.Num() > 0 && Corpses.HeapTop().RecycleTime <= Now && NumRecycled < MaxCorpseRecyclesPerFrame)
+    {
+        FEnemyCorpse Corpse;
+        Corpses.HeapPop(Corpse, false);
+
+        RecycleCorpse(Corpse.Enemy);
+        ++NumRecycled;
+    }
+}
+
+void AEnemySpawner::RecycleCorpse(ACharacter* Enemy)
+{
+    if (!IsValid(Enemy))
+    {
+        return;
+    }
+
+    const FSpawnedEnemyRecord* Record = EnemyRecords.Find(Enemy);
+    if (!Record)
+    {
+        return;
+    }
+
+    if (bUsePooling)
+    {
+        DeactivateEnemy(Enemy);
+        MPAI_COUNT(EnemiesReleased);
+        EnemyPools.FindOrAdd(Record->DataAsset).DormantEnemies.Add(Enemy);
+        INC_DWORD_STAT(STAT_MPAI_PooledAgents);
+        return;
+    }
+
+    DestroyEnemy(Enemy);
+}
+
+void AEnemySpawner::DestroyEnemy(ACharacter* Enemy)
+{
+    AController* Controller = Enemy->GetController();
+    EnemyRecords.Remove(Enemy);
+    Enemy->OnDestroyed.RemoveDynamic(this, &AEnemySpawner::HandleEnemyDestroyed);
+    Enemy->Destroy();
+    if (Controller)
+    {
+        Controller->Destroy();
+    }
+}
+
+void AEnemySpawner::HandleEnemyDestroyed(AActor* DestroyedActor)
+{
+    ACharacter* Enemy = Cast<ACharacter>(DestroyedActor);
+    if (AlertSubsystem)
+    {
+        AlertSubsystem->UnregisterAgent(Enemy);
+    }
+    if (LODSubsystem)
+    {
+        LODSubsystem->UnregisterAgent(Enemy);
+    }
+    RemoveReplicatedAgent(Enemy);
+    if (SpawnedEnemies.Remove(Enemy) > 0)
+    {
+        DEC_DWORD_STAT(STAT_MPAI_LiveAgents);
+    }
+
+    const FSpawnedEnemyRecord* Record = EnemyRecords.Find(Enemy);
+    if (Record && Record->StreamingEntry != INDEX_NONE)
+    {
+        StreamedEnemies[Record->StreamingEntry].Enemy = nullptr;
+    }
+    EnemyRecords.Remove(Enemy);
+}
+
+void AEnemySpawner::ValidateSpawnPoints()
+{
+    MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_ValidateSpawnPoints);
+
+    UWorld* World = GetWorld();
+
+    // Levels without navigation only get the ground snapping
+    UNavigationSystemV1* NavSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+    const ANavigationData* NavData = NavSystem && bProjectSpawnPointsToNavMesh ? NavSystem->GetDefaultNavDataInstance(FNavigationSystem::DontCreate) : nullptr;
+    if (NavData)
+    {
+        TArray<FNavigationProjectionWork> Workload;
+        Workload.Reserve(EnemiesToSpawn.Num());
+        for (const FEnemySpawnData& EnemyData : EnemiesToSpawn)
+        {
+            Workload.Emplace(EnemyData.SpawnTransform.GetLocation());
+        }
+
+        NavData->BatchProjectPoints(Workload, NavProjectionExtent);
+
+        for (int32 EntryIndex = 0; EntryIndex < EnemiesToSpawn.Num(); ++EntryIndex)
+        {
+            if (Workload[EntryIndex].bResult)
+            {
+                EnemiesToSpawn[EntryIndex].SpawnTransform.SetLocation(Workload[EntryIndex].OutLocation.Location);
+            }
+        }
+    }
+
+    FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(MPAISpawnPointValidation), false, this);
+    const FTraceDelegate SweepDelegate = FTraceDelegate::CreateUObject(this, &AEnemySpawner::HandleSpawnPointSweep);
+
+    NumRejectedSpawnPoints = 0;
+    for (int32 EntryIndex = 0; EntryIndex < EnemiesToSpawn.Num(); ++EntryIndex)
+    {
+        const FEnemySpawnData& EnemyData = EnemiesToSpawn[EntryIndex];
+
+        // The class that will actually spawn, the baked prefab included, so the capsule is exact
+        const UClass* CharacterClass = EnemyData.EnemyDataAsset ? EnemyData.EnemyDataAsset->GetCompiledArchetype().CharacterClass : nullptr;
+        const ACharacter* CharacterDefaults = CharacterClass ? CharacterClass->GetDefaultObject<ACharacter>() : GetDefault<ACharacter>();
+        const UCapsuleComponent* Capsule = CharacterDefaults->GetCapsuleComponent();
+        const float HalfHeight = Capsule->GetUnscaledCapsuleHalfHeight();
+
+        // Lifted by a half height so points authored at floor level or on the navmesh start clear of the ground
+        const FVector Location = EnemyData.SpawnTransform.GetLocation();
+        World->AsyncSweepByChannel(EAsyncTraceType::Single,
+            Location + FVector(0.0f, 0.0f, HalfHeight),
+            Location - FVector(0.0f, 0.0f, SpawnPointTraceDistance),
+            FQuat::Identity, SpawnPointTraceChannel,
+            FCollisionShape::MakeCapsule(Capsule->GetUnscaledCapsuleRadius(), HalfHeight),
+            QueryParams, FCollisionResponseParams::DefaultResponseParam, &SweepDelegate, EntryIndex);
+        ++NumPendingSpawnPointSweeps;
+    }
+}
+
+void AEnemySpawner::HandleSpawnPointSweep(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+    const int32 EntryIndex = static_cast<int32>(TraceDatum.UserData);
+    if (EnemiesToSpawn.IsValidIndex(EntryIndex))
+    {
+        const FHitResult* Hit = TraceDatum.OutHits.Num() > 0 ? &TraceDatum.OutHits[0] : nullptr;
+
+        // No ground below, or the capsule does not fit: keep the authored point
+        if (!Hit || !Hit->bBlockingHit || Hit->bStartPenetrating)
+        {
+            ++NumRejectedSpawnPoints;
+            MPAI_COUNT(SpawnPointsRejected);
+            UE_LOG(LogMultiPurposeAI, Verbose, TEXT("%s: spawn point %d %s"), *GetName(), EntryIndex,
+                Hit && Hit->bStartPenetrating ? TEXT("is blocked") : TEXT("has no ground below"));
+        }
+        else
+        {
+            // Capsule center resting on the ground
+            EnemiesToSpawn[EntryIndex].SpawnTransform.SetLocation(Hit->Location);
+            MPAI_COUNT(SpawnPointsSnapped);
+        }
+    }
+
+    if (--NumPendingSpawnPointSweeps > 0)
+    {
+        return;
+    }
+
+    if (NumRejectedSpawnPoints > 0)
+    {
+        UE_LOG(LogMultiPurposeAI, Warning, TEXT("%s: %d of %d spawn points have no ground below or are blocked, they keep their authored transform"),
+            *GetName(), NumRejectedSpawnPoints, EnemiesToSpawn.Num());
+    }
+
+    StartSpawning();
+}
+
+void AEnemySpawner::BuildStreamingCells()
+{
+    StreamingCells.Reset();
+    StreamedEnemies.Reset();
+    StreamedEnemies.SetNum(EnemiesToSpawn.Num());
+
+    const double CellSize = FMath::Max(StreamingCellSize, 100.0f);
+    TMap<FIntPoint, int32> CellIndices;
+
+    for (int32 EntryIndex = 0; EntryIndex < EnemiesToSpawn.Num(); ++EntryIndex)
+    {
+        const FVector Location = EnemiesToSpawn[EntryIndex].SpawnTransform.GetLocation();
+        const FIntPoint Coord(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+
+        int32* CellIndex = CellIndices.Find(Coord);
+        if (!CellIndex)
+        {
+            FEnemyStreamingCell& Cell = StreamingCells.AddDefaulted_GetRef();
+            Cell.Bounds = FBox2D(FVector2D(Coord.X, Coord.Y) * CellSize, FVector2D(Coord.X + 1, Coord.Y + 1) * CellSize);
+            CellIndex = &CellIndices.Add(Coord, StreamingCells.Num() - 1);
+        }
+
+        StreamingCells[*CellIndex].Entries.Add(EntryIndex);
+        StreamedEnemies[EntryIndex].Cell = *CellIndex;
+    }
+}
+
+void AEnemySpawner::GatherStreamingSources(TArray<FVector2D, TInlineAllocator<8>>& OutSources) const
+{
+    for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+    {
+        const APlayerController* PlayerController = It->Get();
+        if (PlayerController)
+        {
+            FVector ViewLocation;
+            FRotator ViewRotation;
+            PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+            OutSources.Add(FVector2D(ViewLocation));
+        }
+    }
+
+    // Only exists in partitioned worlds, where it also knows about non-player sources
+    const UWorldPartitionSubsystem* WorldPartition = GetWorld()->GetSubsystem<UWorldPartitionSubsystem>();
+    if (WorldPartition)
+    {
+        for (const FWorldPartitionStreamingSource& Source : WorldPartition->GetStreamingSources())
+        {
+            OutSources.Add(FVector2D(Source.Location));
+        }
+    }
+}
+
+void AEnemySpawner::UpdateStreaming()
+{
+    MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_StreamingUpdate);
+
+    TArray<FVector2D, TInlineAllocator<8>> Sources;
+    GatherStreamingSources(Sources);
+
+    // Cells between the two radii keep whatever they were doing
+    const double ActivationDistanceSquared = FMath::Square(ActivationRadius);
+    const double DeactivationDistanceSquared = FMath::Square(FMath::Max(DeactivationRadius, ActivationRadius));
+
+    bool bQueuedSpawns = false;
+    for (int32 CellIndex = 0; CellIndex < StreamingCells.Num(); ++CellIndex)
+    {
+        const FEnemyStreamingCell& Cell = StreamingCells[CellIndex];
+
+        double ClosestDistanceSquared = TNumericLimits<double>::Max();
+        for (const FVector2D& Source : Sources)
+        {
+            ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, Cell.Bounds.ComputeSquaredDistanceToPoint(Source));
+        }
+
+        if (!Cell.bActive && ClosestDistanceSquared <= ActivationDistanceSquared)
+        {
+            ActivateStreamingCell(CellIndex);
+            bQueuedSpawns = true;
+        }
+        else if (Cell.bActive && ClosestDistanceSquared > DeactivationDistanceSquared)
+        {
+            DeactivateStreamingCell(CellIndex);
+        }
+    }
+
+    if (bQueuedSpawns && !bTimeSliceSpawning)
+    {
+        FlushSpawnQueue();
+    }
+}
+
+void AEnemySpawner::ActivateStreamingCell(int32 CellIndex)
+{
+    StreamingCells[CellIndex].bActive = true;
+    MPAI_COUNT(StreamingCellsActivated);
+
+    for (const int32 EntryIndex : StreamingCells[CellIndex].Entries)
+    {
+        // Still queued from an earlier visit, or nothing left to bring back
+        FStreamedEnemyState& Entry = StreamedEnemies[EntryIndex];
+        if (Entry.bQueued || Entry.bDead || Entry.Enemy)
+        {
+            continue;
+        }
+
+        FPendingEnemySpawn Pending;
+        Pending.SpawnData = EnemiesToSpawn[EntryIndex];
+        Pending.Priority = static_cast<float>(SpawnQueueSequence++);
+        Pending.StreamingEntry = EntryIndex;
+
+        Entry.bQueued = true;
+        EnqueuePendingSpawn(Pending);
+    }
+}
+
+void AEnemySpawner::DeactivateStreamingCell(int32 CellIndex)
+{
+    StreamingCells[CellIndex].bActive = false;
+    MPAI_COUNT(StreamingCellsDeactivated);
+
+    for (const int32 EntryIndex : StreamingCells[CellIndex].Entries)
+    {
+        FStreamedEnemyState& Entry = StreamedEnemies[EntryIndex];
+        ACharacter* Enemy = Entry.Enemy;
+        FSpawnedEnemyRecord* Record = EnemyRecords.Find(Enemy);
+        if (!IsValid(Enemy) || !Record)
+        {
+            Entry.Enemy = nullptr;
+            continue;
+        }
+
+        CaptureEnemyState(*Record, Entry.SavedHealth, Entry.SavedState);
+
+        // Killed this frame, the damage queue reports the death once the enemy is already gone
+        if (Record->DamageComponent && Entry.SavedHealth <= 0.0f)
+        {
+            Entry.bDead = true;
+        }
+
+        DespawnEnemy(Enemy);
+    }
+}
+
+void AEnemySpawner::SpawnStreamedEnemy(int32 EntryIndex)
+{
+    FStreamedEnemyState& Entry = StreamedEnemies[EntryIndex];
+    Entry.bQueued = false;
+
+    // The cell went out of range again before the entry's turn came
+    if (!StreamingCells[Entry.Cell].bActive || Entry.bDead || Entry.Enemy)
+    {
+        return;
+    }
+
+    ACharacter* Enemy = SpawnEnemy(EnemiesToSpawn[EntryIndex]);
+    FSpawnedEnemyRecord* Record = Enemy ? EnemyRecords.Find(Enemy) : nullptr;
+    if (!Record)
+    {
+        return;
+    }
+
+    Entry.Enemy = Enemy;
+    Record->StreamingEntry = EntryIndex;
+
+    // Put back what the enemy had when it streamed out
+    RestoreEnemyState(*Record, Entry.SavedHealth, Entry.SavedState);
+}
+
+void AEnemySpawner::DespawnEnemy(ACharacter* Enemy)
+{
+    if (bUsePooling)
+    {
+        ReleaseEnemy(Enemy);
+        return;
+    }
+
+    if (SpawnedEnemies.Remove(Enemy) > 0)
+    {
+        DEC_DWORD_STAT(STAT_MPAI_LiveAgents);
+    }
+
+    const FSpawnedEnemyRecord* Record = EnemyRecords.Find(Enemy);
+    if (Record && Record->StreamingEntry != INDEX_NONE)
+    {
+        StreamedEnemies[Record->StreamingEntry].Enemy = nullptr;
+    }
+
+    StopEnemy(Enemy);
+    DestroyEnemy(Enemy);
+}
+
+ACharacter* AEnemySpawner::PromoteCrowdEnemy(const FEnemySpawnData& EnemyData, float Health, EAICharacterState State)
+{
+    ACharacter* Enemy = SpawnEnemy(EnemyData);
+    FSpawnedEnemyRecord* Record = Enemy ? EnemyRecords.Find(Enemy) : nullptr;
+    if (!Record)
+    {
+        return nullptr;
+    }
+
+    RestoreEnemyState(*Record, Health, State);
+    return Enemy;
+}
+
+bool AEnemySpawner::DemoteCrowdEnemy(ACharacter* Enemy, float& OutHealth, EAICharacterState& OutState)
+{
+    const FSpawnedEnemyRecord* Record = EnemyRecords.Find(Enemy);
+    if (!Record || !SpawnedEnemies.Contains(Enemy))
+    {
+        return false;
+    }
+
+    CaptureEnemyState(*Record, OutHealth, OutState);
+    DespawnEnemy(Enemy);
+    return true;
+}
+
+void AEnemySpawner::CaptureEnemyState(const FSpawnedEnemyRecord& Record, float& OutHealth, EAICharacterState& OutState) const
+{
+    OutHealth = Record.DamageComponent ? Record.DamageComponent->GetCurrentHealth() : -1.0f;
+    if (Record.StateManager)
+    {
+        OutState = Record.StateManager->GetCurrentState();
+    }
+    else if (Record.Blackboard)
+    {
+        OutState = static_cast<EAICharacterState>(Record.Blackboard->GetValue<UBlackboardKeyType_Enum>(Record.AIStateKey));
+    }
 }
 
-void AEnemySpawner::BeginPlay()
+void AEnemySpawner::RestoreEnemyState(FSpawnedEnemyRecord& Record, float Health, EAICharacterState State)
 {
-    for (const FEnemySpawnData& EnemyData : EnemiesToSpawn)
+    // Spawning reset both to the archetype defaults
+    if (Health > 0.0f && Record.DamageComponent)
     {
-        ACharacter* SpawnedEnemy = SpawnEnemy(EnemyData);
-        if (SpawnedEnemy)
+        Record.DamageComponent->SetCurrentHealth(FMath::Min(Health, Record.DamageComponent->GetMaxHealth()));
+    }
+
+    if (State != EAICharacterState::None)
+    {
+        if (Record.StateManager)
+        {
+            Record.StateManager->SetCurrentState(State);
+        }
+        else
         {
-            SpawnedEnemies.Add(SpawnedEnemy);
+            WriteBlackboardState(Record.Blackboard, Record.AIStateKey, static_cast<uint8>(State));
         }
+    }
+}
 
+void AEnemySpawner::WriteBlackboardState(UBlackboardComponent* Blackboard, FBlackboard::FKey AIStateKey, uint8 State)
+{
+    if (BlackboardWriter)
+    {
+        BlackboardWriter->SetEnum(Blackboard, AIStateKey, State);
+    }
+    else if (Blackboard)
+    {
+        Blackboard->SetValue<UBlackboardKeyType_Enum>(AIStateKey, State);
     }
 }
 
-// Function to spawn an enemy and assign assets based on the data asset provided
-ACharacter* AEnemySpawner::SpawnEnemy(const FEnemySpawnData& EnemyData)
+void AEnemySpawner::UpdateReplicatedAgentStates()
 {
-    if (!EnemyData.EnemyDataAsset)
+    // Enemies destroyed outside StopEnemy and DestroyEnemy, e.g. by gameplay, kill Z or level streaming
+    AgentStates.RemoveInvalidAgents();
+
+    for (const TObjectPtr<ACharacter>& Enemy : SpawnedEnemies)
     {
-        UE_LOG(LogTemp, Warning, TEXT("Enemy data asset is null! Skipping spawn."));
-        return nullptr;
+        const FSpawnedEnemyRecord* Record = EnemyRecords.Find(Enemy);
+        if (!IsValid(Enemy) || !Record)
+        {
+            continue;
+        }
+
+        EAICharacterState State = EAICharacterState::None;
+        if (Record->StateManager)
+        {
+            State = Record->StateManager->GetCurrentState();
+        }
+        else if (Record->Blackboard)
+        {
+            State = static_cast<EAICharacterState>(Record->Blackboard->GetValue<UBlackboardKeyType_Enum>(Record->AIStateKey));
+        }
+
+        const uint8 QuantizedHealth = Record->DamageComponent
+            ? FAIAgentStateArray::QuantizeHealth(Record->DamageComponent->GetCurrentHealth(), Record->DamageComponent->GetMaxHealth())
+            : MAX_uint8;
+
+        AgentStates.SetAgent(Enemy, static_cast<uint8>(State), QuantizedHealth);
     }
 
-    UWorld* World = GetWorld();
-    if (!World)
+    UpdateAgentStateReplicators();
+    for (AAIAgentStateReplicator* Replicator : AgentStateReplicators)
     {
-        return nullptr;
+        Replicator->UpdateAgentStates(AgentStates);
     }
+}
 
-    // Spawn the enemy
-    ACharacter* SpawnedCharacter = World->SpawnActor<ACharacter>(
-        EnemyData.EnemyDataAsset->CharacterClass, 
-        EnemyData.SpawnTransform);
+void AEnemySpawner::UpdateAgentStateReplicators()
+{
+    AgentStateReplicators.RemoveAll([](AAIAgentStateReplicator* Replicator)
+    {
+        if (IsValid(Replicator) && IsValid(Replicator->GetOwner()))
+        {
+            return false;
+        }
+        if (IsValid(Replicator))
+        {
+            Replicator->Destroy();
+        }
+        return true;
+    });
 
-    if (SpawnedCharacter)
+    for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+    {
+        APlayerController* PlayerController = It->Get();
+
+        // A listen server's own player reads AgentStates directly
+        if (!PlayerController || PlayerController->IsLocalController()
+            || AgentStateReplicators.ContainsByPredicate([PlayerController](const AAIAgentStateReplicator* Replicator) { return Replicator->GetOwner() == PlayerController; }))
+        {
+            continue;
+        }
+
+        FActorSpawnParameters SpawnParams;
+        SpawnParams.Owner = PlayerController;
+        AAIAgentStateReplicator* Replicator = GetWorld()->SpawnActor<AAIAgentStateReplicator>(SpawnParams);
+        if (Replicator)
+        {
+            Replicator->Initialize(this);
+            AgentStateReplicators.Add(Replicator);
+        }
+    }
+}
+
+void AEnemySpawner::RemoveReplicatedAgent(const ACharacter* Enemy)
+{
+    AgentStates.RemoveAgent(Enemy);
+    for (AAIAgentStateReplicator* Replicator : AgentStateReplicators)
+    {
+        if (IsValid(Replicator))
+        {
+            Replicator->RemoveAgent(Enemy);
+        }
+    }
+}
+
+void AEnemySpawner::SetLocalAgentStateReplicator(AAIAgentStateReplicator* Replicator)
+{
+    LocalAgentStateReplicator = Replicator;
+}
+
+bool AEnemySpawner::GetReplicatedAgentState(const ACharacter* Agent, EAICharacterState& OutState, float& OutHealthFraction) const
+{
+    // The server knows every live enemy, a client only the ones relevant to its player
+    const AAIAgentStateReplicator* Replicator = LocalAgentStateReplicator.Get();
+    const FAIAgentStateArray* States = HasAuthority() ? &AgentStates : (Replicator ? &Replicator->GetAgentStates() : nullptr);
+    const FAIAgentStateItem* Item = States ? States->FindAgent(Agent) : nullptr;
+    if (!Item)
+    {
+        return false;
+    }
+
+    OutState = static_cast<EAICharacterState>(Item->State);
+    OutHealthFraction = Item->GetHealthFraction();
+    return true;
+}
+
+void AEnemySpawner::SaveSnapshot(TArray<uint8>& OutData) const
+{
+    MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_SaveSnapshot);
+
+    if (SpawnQueue.Num() > 0 || NumSpawnsWaitingForLoad > 0)
+    {
+        UE_LOG(LogMultiPurposeAI, Warning, TEXT("%s: snapshot taken with spawns still queued, only live enemies are saved"), *GetName());
+    }
+
+    FEnemySpawnerSnapshot Snapshot;
+    Snapshot.Reserve(SpawnedEnemies.Num());
+
+    TMap<const UCharacterDataAsset*, uint16> ArchetypeIndices;
+    for (const TObjectPtr<ACharacter>& Enemy : SpawnedEnemies)
     {
-        AAIController* AIController = Cast<AAIController>(SpawnedCharacter->GetController());
+        const FSpawnedEnemyRecord* Record = EnemyRecords.Find(Enemy);
+        if (!IsValid(Enemy) || !Record || !Record->DataAsset)
+        {
+            continue;
+        }
+
+        const uint16* ArchetypeIndex = ArchetypeIndices.Find(Record->DataAsset);
+        if (!ArchetypeIndex)
+        {
+            ArchetypeIndex = &ArchetypeIndices.Add(Record->DataAsset, static_cast<uint16>(Snapshot.Archetypes.Num()));
+            Snapshot.Archetypes.Add(Record->DataAsset->GetPathName());
+        }
+
+        const EAICharacterState State = Record->StateManager ? Record->StateManager->GetCurrentState() : EAICharacterState::None;
+        const uint8 BlackboardState = Record->Blackboard && Record->AIStateKey != FBlackboard::InvalidKey
+            ? Record->Blackboard->GetValue<UBlackboardKeyType_Enum>(Record->AIStateKey)
+            : static_cast<uint8>(State);
+
+        Snapshot.ArchetypeIndices.Add(*ArchetypeIndex);
+        Snapshot.Locations.Add(FVector3f(Enemy->GetActorLocation()));
+        Snapshot.Yaws.Add(static_cast<float>(Enemy->GetActorRotation().Yaw));
+        Snapshot.SquadIds.Add(Record->SquadId);
+        Snapshot.Health.Add(Record->DamageComponent ? Record->DamageComponent->GetCurrentHealth() : -1.0f);
+        Snapshot.States.Add(static_cast<uint8>(State));
+        Snapshot.BlackboardStates.Add(BlackboardState);
+        Snapshot.StreamingEntries.Add(Record->StreamingEntry);
+    }
 
-        // If the character doesn't have a controller, create one
-        if (!AIController)
+    if (bUseProximityStreaming)
+    {
+        Snapshot.StreamedHealth.Reserve(StreamedEnemies.Num());
+        for (const FStreamedEnemyState& Entry : StreamedEnemies)
+        {
+            Snapshot.StreamedHealth.Add(Entry.SavedHealth);
+            Snapshot.StreamedStates.Add(static_cast<uint8>(Entry.SavedState));
+            Snapshot.StreamedDead.Add(Entry.bDead ? 1 : 0);
+        }
+        for (const FEnemyStreamingCell& Cell : StreamingCells)
         {
-            // Spawn the default AI controller for the character
-            SpawnedCharacter->SpawnDefaultController();
+            Snapshot.ActiveCells.Add(Cell.bActive ? 1 : 0);
+        }
+    }
+
+    OutData.Reset();
+    FMemoryWriter Writer(OutData);
+    Snapshot.Serialize(Writer);
+}
+
+bool AEnemySpawner::RestoreSnapshot(const TArray<uint8>& Data)
+{
+    TSharedRef<FEnemySpawnerSnapshot> Snapshot = MakeShared<FEnemySpawnerSnapshot>();
+    FMemoryReader Reader(Data);
+    if (!Snapshot->Serialize(Reader))
+    {
+        UE_LOG(LogMultiPurposeAI, Warning, TEXT("%s: could not read the enemy snapshot (%d bytes)"), *GetName(), Data.Num());
+        return false;
+    }
 
-            // Get the newly created controller
-            AIController = Cast<AAIController>(SpawnedCharacter->GetController());
+    // A restore still waiting for its archetypes is superseded
+    PendingSnapshot = Snapshot;
+    PendingSnapshotArchetypes.Reset();
 
-            
+    TArray<FSoftObjectPath> DataAssetPaths;
+    for (const FString& ArchetypePath : Snapshot->Archetypes)
+    {
+        DataAssetPaths.Emplace(ArchetypePath);
+    }
+
+    // The delegate fires right away when every data asset is already in memory
+    PendingSnapshotHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+        DataAssetPaths,
+        FStreamableDelegate::CreateUObject(this, &AEnemySpawner::HandleSnapshotDataAssetsLoaded, Snapshot.ToWeakPtr()),
+        FStreamableManager::AsyncLoadHighPriority);
+    if (!PendingSnapshotHandle.IsValid())
+    {
+        // Nothing to load, e.g. a snapshot without enemies
+        HandleSnapshotDataAssetsLoaded(Snapshot.ToWeakPtr());
+    }
+
+    return true;
+}
+
+void AEnemySpawner::HandleSnapshotDataAssetsLoaded(TWeakPtr<FEnemySpawnerSnapshot> Snapshot)
+{
+    // Superseded by a later restore, or already handled
+    if (!PendingSnapshot.IsValid() || Snapshot.Pin() != PendingSnapshot || PendingSnapshotArchetypes.Num() > 0)
+    {
+        return;
+    }
+
+    // Resolved once, every agent is a plain index lookup when the snapshot is applied
+    TArray<TObjectPtr<UCharacterDataAsset>> Archetypes;
+    Archetypes.Reserve(PendingSnapshot->Archetypes.Num());
+    for (const FString& ArchetypePath : PendingSnapshot->Archetypes)
+    {
+        UCharacterDataAsset* Archetype = Cast<UCharacterDataAsset>(FSoftObjectPath(ArchetypePath).ResolveObject());
+        if (!Archetype)
+        {
+            UE_LOG(LogMultiPurposeAI, Warning, TEXT("%s: snapshot archetype %s could not be loaded, its enemies are skipped"), *GetName(), *ArchetypePath);
         }
+        Archetypes.Add(Archetype);
+    }
 
-        // Initialize the enemy with the assigned AIController
-        if (AIController)
+    // Filled before preloading, an archetype already resident calls back into TryApplyPendingSnapshot
+    PendingSnapshotArchetypes = MoveTemp(Archetypes);
+    for (UCharacterDataAsset* Archetype : PendingSnapshotArchetypes)
+    {
+        PreloadArchetype(Archetype);
+    }
+
+    TryApplyPendingSnapshot();
+}
+
+void AEnemySpawner::TryApplyPendingSnapshot()
+{
+    if (!PendingSnapshot.IsValid() || PendingSnapshotArchetypes.Num() != PendingSnapshot->Archetypes.Num())
+    {
+        return;
+    }
+
+    for (const UCharacterDataAsset* Archetype : PendingSnapshotArchetypes)
+    {
+        if (Archetype && !IsArchetypeResident(Archetype))
         {
-            InitializeEnemy(SpawnedCharacter, EnemyData.EnemyDataAsset, AIController); 
-            AssignAIPerceptionConfig(SpawnedCharacter, EnemyData.EnemyDataAsset, AIController);
+            return;
         }
     }
-    
 
-    SpawnedCharacter->SetActorLocation(EnemyData.SpawnTransform.GetLocation(), false, nullptr, ETeleportType::None);
-    FRotator SpawnRotation = EnemyData.SpawnTransform.GetRotation().Rotator();
-    SpawnedCharacter->SetActorRotation(SpawnRotation);
+    const TSharedPtr<FEnemySpawnerSnapshot> Snapshot = MoveTemp(PendingSnapshot);
+    const TArray<UCharacterDataAsset*> Archetypes(PendingSnapshotArchetypes);
+    PendingSnapshotArchetypes.Reset();
+    PendingSnapshotHandle.Reset();
 
-    return SpawnedCharacter;
+    ApplySnapshot(*Snapshot, Archetypes);
+}
+
+void AEnemySpawner::ApplySnapshot(const FEnemySpawnerSnapshot& Snapshot, const TArray<UCharacterDataAsset*>& Archetypes)
+{
+    MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_RestoreSnapshot);
+
+    // The snapshot replaces whatever was alive or still waiting to spawn, pool prewarming carries on
+    SpawnQueue.RemoveAll([](const FPendingEnemySpawn& Pending) { return !Pending.bPrewarmOnly; });
+    for (TPair<TObjectPtr<UCharacterDataAsset>, FArchetypePreload>& Pair : ArchetypePreloads)
+    {
+        NumSpawnsWaitingForLoad -= Pair.Value.WaitingSpawns.RemoveAll([](const FPendingEnemySpawn& Pending) { return !Pending.bPrewarmOnly; });
+    }
+
+    const TArray<TObjectPtr<ACharacter>> LiveEnemies = SpawnedEnemies;
+    for (ACharacter* Enemy : LiveEnemies)
+    {
+        if (IsValid(Enemy))
+        {
+            DespawnEnemy(Enemy);
+        }
+    }
+
+    // Streaming state only applies to the same EnemiesToSpawn layout
+    const bool bRestoreStreaming = bUseProximityStreaming
+        && Snapshot.StreamedHealth.Num() == StreamedEnemies.Num()
+        && Snapshot.ActiveCells.Num() == StreamingCells.Num();
+    if (bRestoreStreaming)
+    {
+        for (int32 EntryIndex = 0; EntryIndex < StreamedEnemies.Num(); ++EntryIndex)
+        {
+            FStreamedEnemyState& Entry = StreamedEnemies[EntryIndex];
+            Entry.Enemy = nullptr;
+            Entry.bQueued = false;
+            Entry.SavedHealth = Snapshot.StreamedHealth[EntryIndex];
+            Entry.SavedState = static_cast<EAICharacterState>(Snapshot.StreamedStates[EntryIndex]);
+            Entry.bDead = Snapshot.StreamedDead[EntryIndex] != 0;
+        }
+        for (int32 CellIndex = 0; CellIndex < StreamingCells.Num(); ++CellIndex)
+        {
+            StreamingCells[CellIndex].bActive = Snapshot.ActiveCells[CellIndex] != 0;
+        }
+    }
+
+    TGuardValue<bool> SpawnBatchGuard(bInSpawnBatch, true);
+
+    FEnemySpawnData SpawnData;
+    for (int32 Index = 0; Index < Snapshot.Num(); ++Index)
+    {
+        SpawnData.EnemyDataAsset = Archetypes.IsValidIndex(Snapshot.ArchetypeIndices[Index]) ? Archetypes[Snapshot.ArchetypeIndices[Index]] : nullptr;
+        if (!SpawnData.EnemyDataAsset)
+        {
+            continue;
+        }
+        SpawnData.SpawnTransform = FTransform(FRotator(0.0f, Snapshot.Yaws[Index], 0.0f), FVector(Snapshot.Locations[Index]));
+        SpawnData.SquadId = Snapshot.SquadIds[Index];
+
+        ACharacter* Enemy = SpawnEnemy(SpawnData);
+        FSpawnedEnemyRecord* Record = Enemy ? EnemyRecords.Find(Enemy) : nullptr;
+        if (!Record)
+        {
+            continue;
+        }
+
+        RestoreEnemyState(*Record, Snapshot.Health[Index], static_cast<EAICharacterState>(Snapshot.States[Index]));
+        if (Record->AIStateKey != FBlackboard::InvalidKey)
+        {
+            WriteBlackboardState(Record->Blackboard, Record->AIStateKey, Snapshot.BlackboardStates[Index]);
+        }
+
+        const int32 StreamingEntry = Snapshot.StreamingEntries[Index];
+        if (bRestoreStreaming && StreamedEnemies.IsValidIndex(StreamingEntry))
+        {
+            StreamedEnemies[StreamingEntry].Enemy = Enemy;
+            Record->StreamingEntry = StreamingEntry;
+        }
+    }
+
+    // Every restored enemy joins the perception system in one go
+    FlushPerceptionRegistrations();
+    UpdateTickEnabled();
+
+    OnSnapshotRestored.Broadcast();
 }
 
 // Function to initialize the enemy's mesh, animation blueprint, and behavior tree
 void AEnemySpawner::InitializeEnemy(ACharacter* SpawnedCharacter, const UCharacterDataAsset* CharacterDataAsset, AAIController* AICharacterController)
 {
+    MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_InitializeEnemy);
+
+    // Resolved once per data asset, everything below is plain pointer and key ID work
+    const FCompiledCharacterArchetype& Archetype = CharacterDataAsset->GetCompiledArchetype();
+
     if (SpawnedCharacter)
     {
         // Set the character's mesh and animation blueprint
-        if (CharacterDataAsset->CharacterMesh)
+        if (Archetype.CharacterMesh && SpawnedCharacter->GetMesh()->GetSkeletalMeshAsset() != Archetype.CharacterMesh)
         {
-            SpawnedCharacter->GetMesh()->SetSkeletalMesh(CharacterDataAsset->CharacterMesh);
+            SpawnedCharacter->GetMesh()->SetSkeletalMesh(Archetype.CharacterMesh);
         }
 
-        if (CharacterDataAsset->AnimationBlueprint)
+        // Re-assigning the same class would still re-create the anim instance
+        if (Archetype.AnimationBlueprint && SpawnedCharacter->GetMesh()->GetAnimClass() != Archetype.AnimationBlueprint)
         {
-            SpawnedCharacter->GetMesh()->SetAnimInstanceClass(CharacterDataAsset->AnimationBlueprint);
+            SpawnedCharacter->GetMesh()->SetAnimInstanceClass(Archetype.AnimationBlueprint);
         }
     }
 
     AddComponentsToCharacter(CharacterDataAsset, SpawnedCharacter);
 
-    bool bSuccess = AICharacterController->RunBehaviorTree(CharacterDataAsset->MainBT);
+    // Has to be the controller's brain before RunBehaviorTree creates a plain behavior tree component
+    if (FAIBehaviorTreeProfiler::IsEnabled())
+    {
+        UProfiledBehaviorTreeComponent::InstallOn(AICharacterController, CharacterDataAsset);
+    }
+
+    bool bSuccess = AICharacterController->RunBehaviorTree(Archetype.MainBT);
+
+    // Spawner enemies get their components and blackboard cached once, pooled ones come back with them
+    FSpawnedEnemyRecord* Record = EnemyRecords.Find(SpawnedCharacter);
+    if (Record && !Record->bComponentsCached)
+    {
+        CacheEnemyRecord(SpawnedCharacter, *Record);
+    }
+
     if(bSuccess)
     {
         UBlackboardComponent* BlackboardComp = AICharacterController->GetBlackboardComponent();
         if (BlackboardComp)
         {
-            // Initialize AIState for EAICharacterState
-            UEnum* AIState = StaticEnum<EAICharacterState>();
+            // Key IDs are only valid for the blackboard asset they were resolved against
+            const bool bKeysResolved = BlackboardComp->GetBlackboardAsset() == Archetype.BlackboardAsset;
 
-            for (const auto& Pair : CharacterDataAsset->Subtrees)
+            for (const FCompiledSubtreeKey& SubtreeKey : Archetype.SubtreeKeys)
             {
-                EAICharacterState State = Pair.Key;         // Key: AI character state
-                UBehaviorTree* Subtree = Pair.Value;       // Value: Behavior tree
+                const FBlackboard::FKey KeyID = bKeysResolved ? SubtreeKey.KeyID : BlackboardComp->GetKeyID(SubtreeKey.KeyName);
 
-                if (Subtree)
+                // Set the behavior tree as an object in the blackboard, pooled enemies usually hold it already
+                if (BlackboardWriter)
                 {
-                    // Get the display name of the enum value (e.g., "Patrol" instead of "EAICharacterState::Patrol")
-                    FString StateString = *AIState->GetNameStringByValue((int64)State);
-                    // Create the blackboard key with the format EnumName + "SubTree"
-                    FString BlackboardKeyString = StateString + "SubTree";
-                    FName BlackboardKey = FName(*BlackboardKeyString);
-
-                    // Set the behavior tree as an object in the blackboard
-                    BlackboardComp->SetValueAsObject(BlackboardKey, Subtree);
+                    BlackboardWriter->SetObject(BlackboardComp, KeyID, SubtreeKey.Subtree);
+                }
+                else
+                {
+                    BlackboardComp->SetValue<UBlackboardKeyType_Object>(KeyID, SubtreeKey.Subtree);
                 }
-            }
-            UStateManagerComponent* StateManager = SpawnedCharacter->GetComponentByClass<UStateManagerComponent>();
-            if(StateManager)
-            {
-                StateManager->SetCurrentState(CharacterDataAsset->DefaultStartState);
             }
 
-            UDamageableComponent* DamageComponent = SpawnedCharacter->GetComponentByClass<UDamageableComponent>();
+            // Only characters initialized from Blueprint without a record are searched
+            UDamageableComponent* DamageComponent = Record ? Record->DamageComponent.Get() : SpawnedCharacter->GetComponentByClass<UDamageableComponent>();
             if (DamageComponent)
             {
                 DamageComponent->SetMaxHealth(CharacterDataAsset->MaxHealth);
                 DamageComponent->SetCurrentHealth(DamageComponent->GetMaxHealth());
             }
 
-            FName AIStateBlackboardKey = FName("AIState");
-            BlackboardComp->SetValueAsEnum(AIStateBlackboardKey, static_cast<uint8>(CharacterDataAsset->DefaultStartState));
+            const FBlackboard::FKey AIStateKey = bKeysResolved ? Archetype.AIStateKey : BlackboardComp->GetKeyID(UCharacterDataAsset::AIStateKeyName);
+
+            // The state subsystem mirrors later changes into the blackboard
+            UStateManagerComponent* StateManager = Record ? Record->StateManager.Get() : SpawnedCharacter->GetComponentByClass<UStateManagerComponent>();
+            if(StateManager)
+            {
+                StateManager->BindBlackboard(BlackboardComp, AIStateKey);
+                StateManager->SetCurrentState(CharacterDataAsset->DefaultStartState);
+            }
+
+            // Written by hand even with a state manager, its mirror only flushes in the subsystem's Tick.
+            // The mirror write that follows holds the same value and is dropped by the writer
+            WriteBlackboardState(BlackboardComp, AIStateKey, static_cast<uint8>(CharacterDataAsset->DefaultStartState));
 
+            // The tree starts on its final keys, with one round of observer notifications for all of them
+            if (BlackboardWriter)
+            {
+                BlackboardWriter->FlushBlackboard(BlackboardComp);
+            }
         }
     }
 }
 
 void AEnemySpawner::AddComponentsToCharacter(const UCharacterDataAsset* CharacterDataAsset, ACharacter* SpawnedEnemy)
 {
+    MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_AddComponents);
+
     if (!SpawnedEnemy || !CharacterDataAsset)
     {
-        UE_LOG(LogTemp, Error, TEXT("Invalid SpawnedEnemy or CharacterDataAsset!"));
+        UE_LOG(LogMultiPurposeAI, Error, TEXT("Invalid SpawnedEnemy or CharacterDataAsset!"));
         return;
     }
 
     if (CharacterDataAsset->bEnableComponents)
     {
-        UE_LOG(LogTemp, Warning, TEXT("Adding components to character: %s"), *SpawnedEnemy->GetName());
-        UE_LOG(LogTemp, Warning, TEXT("ComponentsToAdd has %d elements"), CharacterDataAsset->ComponentsToAdd.Num());
+        // Invalid entries of ComponentsToAdd were already filtered out when the archetype was compiled
+        const TArray<TSubclassOf<UActorComponent>>& ComponentClasses = CharacterDataAsset->GetCompiledArchetype().ComponentClasses;
 
-        for (const TSubclassOf<UActorComponent>& CompClass : CharacterDataAsset->ComponentsToAdd)
+        for (const TSubclassOf<UActorComponent>& CompClass : ComponentClasses)
         {
-            if (!CompClass || !CompClass->IsChildOf(UActorComponent::StaticClass()))
+            // Pooled characters come back with their components already added
+            if (SpawnedEnemy->FindComponentByClass(CompClass))
             {
-                UE_LOG(LogTemp, Error, TEXT("Invalid component class in ComponentsToAdd!"));
                 continue;
             }
 
@@ -178,78 +1802,116 @@ void AEnemySpawner::AddComponentsToCharacter(const UCharacterDataAsset* Characte
 
             if (NewComponent)
             {
-                UE_LOG(LogTemp, Warning, TEXT("Successfully created component: %s"), *NewComponent->GetName());
-
                 // Register the component with the actor
                 NewComponent->RegisterComponent();
                 NewComponent->SetActive(true);
-
-                UE_LOG(LogTemp, Warning, TEXT("Registered and activated component: %s"), *NewComponent->GetName());
+                MPAI_COUNT(ComponentsAdded);
 
                 // Attach the component to the actor
                 SpawnedEnemy->AddOwnedComponent(NewComponent);  // Add it to the actor's owned components
             }
         }
     }
-    else
-    {
-        UE_LOG(LogTemp, Warning, TEXT("bEnableComponents is false, no components added."));
-    }
 }
 
 void AEnemySpawner::AssignAIPerceptionConfig(ACharacter* SpawnedCharacter, const UCharacterDataAsset* CharacterDataAsset, AAIController* AICharacterController)
 {
+    MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_AssignPerceptionConfig);
+
     if (!SpawnedCharacter || !CharacterDataAsset || !AICharacterController)
     {
-        UE_LOG(LogTemp, Warning, TEXT("Invalid parameters in AssignAIPerceptionConfig"));
+        UE_LOG(LogMultiPurposeAI, Warning, TEXT("Invalid parameters in AssignAIPerceptionConfig"));
         return;
     }
 
-    UAIPerceptionComponent* PerceptionComponent = AICharacterController->FindComponentByClass<UAIPerceptionComponent>();
+    // Resolved once per archetype: valid configs, one per sense class
+    const TArray<TObjectPtr<UAISenseConfig>>& SenseConfigs = CharacterDataAsset->GetCompiledArchetype().SenseConfigs;
+    FSpawnedEnemyRecord* Record = EnemyRecords.Find(SpawnedCharacter);
+
+    for (const TObjectPtr<UAISenseConfig>& SenseConfig : SenseConfigs)
+    {
+        ListenerSenses.Add(SenseConfig->GetSenseImplementation());
+    }
+
+    UAIPerceptionComponent* PerceptionComponent = AICharacterController->GetPerceptionComponent();
+    if (!PerceptionComponent)
+    {
+        PerceptionComponent = AICharacterController->FindComponentByClass<UAIPerceptionComponent>();
+    }
 
     if (!PerceptionComponent)
     {
-        // Create and register a new Perception Component at runtime
+        // Create a new Perception Component at runtime
         PerceptionComponent = NewObject<UAIPerceptionComponent>(AICharacterController);
-        PerceptionComponent->RegisterComponent();
+        AICharacterController->SetPerceptionComponent(*PerceptionComponent);
 
-        if (PerceptionComponent)
+        for (const TObjectPtr<UAISenseConfig>& SenseConfig : SenseConfigs)
         {
-            AICharacterController->SetPerceptionComponent(*PerceptionComponent);
+            PerceptionComponent->ConfigureSense(*SenseConfig);
+            MPAI_COUNT(SensesConfigured);
+        }
+        if (CharacterDataAsset->DominantSense)
+        {
+            PerceptionComponent->SetDominantSense(CharacterDataAsset->DominantSense);
         }
-    }
 
-    if (PerceptionComponent)
+        // Not registered yet, so none of the above touched the perception system. The listener is added
+        // once with its final senses, together with the other enemies of this spawn batch
+        if (bBatchPerceptionSetup)
+        {
+            PendingPerceptionRegistrations.Add(PerceptionComponent);
+            UpdateTickEnabled();
+        }
+        else
+        {
+            PerceptionComponent->RegisterComponent();
+        }
+    }
+    else if (!bBatchPerceptionSetup || !Record || !Record->PerceptionRelay)
     {
-        
-
-        // Configure senses from data asset
-        for (const TObjectPtr<UAISenseConfig>& SenseConfig : CharacterDataAsset->SensesConfig)
+        // Controller class came with its own component, or the enemy is being set up again without batching
+        for (const TObjectPtr<UAISenseConfig>& SenseConfig : SenseConfigs)
         {
-            if (SenseConfig)
-            {
-                UE_LOG(LogTemp, Error, TEXT("Sense: %s"), *SenseConfig->GetName());
-                
-                PerceptionComponent->ConfigureSense( *SenseConfig);
-            }
+            PerceptionComponent->ConfigureSense(*SenseConfig);
+            MPAI_COUNT(SensesConfigured);
         }
-        
-        
-        // Set dominant sense
         if (CharacterDataAsset->DominantSense)
         {
             PerceptionComponent->SetDominantSense(CharacterDataAsset->DominantSense);
             PerceptionComponent->RequestStimuliListenerUpdate();
-        }  
-        // Ensure activation
-        PerceptionComponent->Activate();
-        // Add dynamic delegate for perception updates
-        PerceptionComponent->OnPerceptionUpdated.AddDynamic(this, &AEnemySpawner::OnPerceptionUpdated);
-        if (PerceptionComponent->OnPerceptionUpdated.IsBound())
+        }
+    }
+    // else: a pooled enemy coming back, its component still holds this archetype's senses
+
+    // Ensure activation
+    PerceptionComponent->Activate();
+
+    // Route this enemy's perception events through its own relay, once per enemy
+    if (Record && !Record->PerceptionRelay)
+    {
+        Record->PerceptionRelay = NewObject<UEnemyPerceptionRelay>(AICharacterController);
+        Record->PerceptionRelay->Initialize(this, SpawnedCharacter);
+        PerceptionComponent->OnTargetPerceptionUpdated.AddUniqueDynamic(Record->PerceptionRelay, &UEnemyPerceptionRelay::OnTargetPerceptionUpdated);
+    }
+}
+
+void AEnemySpawner::FlushPerceptionRegistrations()
+{
+    if (PendingPerceptionRegistrations.Num() == 0)
+    {
+        return;
+    }
+
+    MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_AssignPerceptionConfig);
+
+    for (UAIPerceptionComponent* PerceptionComponent : PendingPerceptionRegistrations)
+    {
+        if (IsValid(PerceptionComponent) && !PerceptionComponent->IsRegistered())
         {
-            UE_LOG(LogTemp, Log, TEXT("Perception delegate successfully bound."));
+            PerceptionComponent->RegisterComponent();
         }
     }
+    PendingPerceptionRegistrations.Reset();
 }
 
 void AEnemySpawner::OnConstruction(const FTransform& Transform)
@@ -297,37 +1959,56 @@ void AEnemySpawner::OnConstruction(const FTransform& Transform)
 
 
 
-void AEnemySpawner::OnPerceptionUpdated(const TArray<AActor*>& UpdatedActors)
+void AEnemySpawner::HandleTargetPerceptionUpdated(ACharacter* Enemy, AActor* Actor, const FAIStimulus& Stimulus)
 {
-    UE_LOG(LogTemp, Warning, TEXT("Called"));
-    // Handle perception updates
-    for (AActor* Actor : UpdatedActors)
+    MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_PerceptionUpdated);
+
+    if (!Actor || !Stimulus.WasSuccessfullySensed())
     {
-        if (Actor)
-        {
-            UE_LOG(LogTemp, Warning, TEXT("Perceived Actor: %s"), *Actor->GetName());
+        return;
+    }
 
-            int32 Index = 0;
-            for (ACharacter* Enemy : SpawnedEnemies)
-            {
-                if (Enemy)
-                {
-                    FEnemySpawnData* EnemyData = &EnemiesToSpawn[Index];
-
-                    AAIController* AIController = Cast<AAIController>(Enemy->GetController());
-                    if (AIController)
-                    {
-                        UBlackboardComponent* BlackBoard = AIController->GetBlackboardComponent();
-                        FName AIStateBlackboardKey = FName("AIState");
-                        BlackBoard->SetValueAsEnum(AIStateBlackboardKey, static_cast<uint8>(EnemyData->EnemyDataAsset->DetectionState));
-                        UStateManagerComponent* StateManager = Enemy->GetComponentByClass<UStateManagerComponent>();
-                        StateManager->SetCurrentState(EnemyData->EnemyDataAsset->DetectionState);
-                    }
-                }
-                Index++;
-            }
+    MPAI_COUNT(PerceptionEvents);
+    UE_LOG(LogMultiPurposeAI, VeryVerbose, TEXT("%s perceived %s"), *GetNameSafe(Enemy), *Actor->GetName());
+
+    // Allies from this spawner are perceived too, they don't trigger a detection
+    if (EnemyRecords.Contains(Cast<ACharacter>(Actor)))
+    {
+        return;
+    }
+
+    const FSpawnedEnemyRecord* Record = EnemyRecords.Find(Enemy);
+    if (!Record || !Record->DataAsset)
+    {
+        return;
+    }
+
+    const EAICharacterState DetectionState = Record->DataAsset->DetectionState;
+
+    // Already reacting, nothing to write and allies were alerted the first time
+    if (Record->StateManager && Record->StateManager->GetCurrentState() == DetectionState)
+    {
+        return;
+    }
+
+    if (Record->StateManager)
+    {
+        // The archetype's transition table may refuse the detection (e.g. while on cooldown)
+        if (!Record->StateManager->RequestStateChange(DetectionState))
+        {
+            return;
         }
     }
-}
+    else
+    {
+        WriteBlackboardState(Record->Blackboard, Record->AIStateKey, static_cast<uint8>(DetectionState));
+    }
 
+    MPAI_COUNT(Detections);
 
+    // Neighbours and squad mates react at the end of the frame, in one batch
+    if (AlertSubsystem && (Record->DataAsset->AlertRadius > 0.0f || Record->SquadId != INDEX_NONE))
+    {
+        AlertSubsystem->RaiseAlert(Enemy, Record->DataAsset->AlertRadius);
+    }
+}
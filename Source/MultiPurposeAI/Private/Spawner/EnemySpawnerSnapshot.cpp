@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Spawner/EnemySpawnerSnapshot.h"
+#include "Enums.h"
+#include "Serialization/Archive.h"
+#include "UObject/Class.h"
+
+namespace EnemySpawnerSnapshot
+{
+    // The states are cast straight back to EAICharacterState on restore
+    static bool AreValidStates(const TArray<uint8>& States)
+    {
+        // The last entry is the generated _MAX, not a state
+        const UEnum* StateEnum = StaticEnum<EAICharacterState>();
+        const int32 NumStates = StateEnum->NumEnums() - 1;
+        return !States.ContainsByPredicate([StateEnum, NumStates](uint8 State)
+        {
+            const int32 StateIndex = StateEnum->GetIndexByValue(State);
+            return StateIndex == INDEX_NONE || StateIndex >= NumStates;
+        });
+    }
+}
+
+void FEnemySpawnerSnapshot::Reserve(int32 NumAgents)
+{
+    ArchetypeIndices.Reserve(NumAgents);
+    Locations.Reserve(NumAgents);
+    Yaws.Reserve(NumAgents);
+    SquadIds.Reserve(NumAgents);
+    Health.Reserve(NumAgents);
+    States.Reserve(NumAgents);
+    BlackboardStates.Reserve(NumAgents);
+    StreamingEntries.Reserve(NumAgents);
+}
+
+bool FEnemySpawnerSnapshot::Serialize(FArchive& Ar)
+{
+    uint32 FileMagic = Magic;
+    uint32 Version = static_cast<uint32>(EEnemySnapshotVersion::Latest);
+    Ar << FileMagic;
+    Ar << Version;
+
+    if (Ar.IsLoading() && (FileMagic != Magic || Version == 0 || Version > static_cast<uint32>(EEnemySnapshotVersion::Latest)))
+    {
+        Ar.SetError();
+        return false;
+    }
+
+    Ar << Archetypes;
+
+    // Plain old data, each array goes through as one memcpy
+    ArchetypeIndices.BulkSerialize(Ar);
+    Locations.BulkSerialize(Ar);
+    Yaws.BulkSerialize(Ar);
+    SquadIds.BulkSerialize(Ar);
+    Health.BulkSerialize(Ar);
+    States.BulkSerialize(Ar);
+    BlackboardStates.BulkSerialize(Ar);
+    StreamingEntries.BulkSerialize(Ar);
+
+    StreamedHealth.BulkSerialize(Ar);
+    StreamedStates.BulkSerialize(Ar);
+    StreamedDead.BulkSerialize(Ar);
+    ActiveCells.BulkSerialize(Ar);
+
+    if (Ar.IsError())
+    {
+        return false;
+    }
+
+    const int32 NumAgents = Num();
+    const bool bAgentsConsistent = Locations.Num() == NumAgents && Yaws.Num() == NumAgents && SquadIds.Num() == NumAgents
+        && Health.Num() == NumAgents && States.Num() == NumAgents && BlackboardStates.Num() == NumAgents && StreamingEntries.Num() == NumAgents;
+    const bool bStreamingConsistent = StreamedStates.Num() == StreamedHealth.Num() && StreamedDead.Num() == StreamedHealth.Num();
+    const bool bStatesValid = EnemySpawnerSnapshot::AreValidStates(States) && EnemySpawnerSnapshot::AreValidStates(BlackboardStates)
+        && EnemySpawnerSnapshot::AreValidStates(StreamedStates);
+    if (Ar.IsLoading() && (!bAgentsConsistent || !bStreamingConsistent || !bStatesValid))
+    {
+        Ar.SetError();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,290 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/AICrowdSubsystem.h"
+#include "Mass/AICrowdFragments.h"
+#include "Mass/AICrowdProcessors.h"
+#include "Spawner/EnemySpawner.h"
+#include "Data/CharacterDataAsset.h"
+#include "Diagnostics/AIStats.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "MassEntitySubsystem.h"
+#include "MassExecutor.h"
+#include "MassProcessingTypes.h"
+
+void UAICrowdSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+    Collection.InitializeDependency<UMassEntitySubsystem>();
+
+    SignificanceProcessor = NewObject<UAICrowdSignificanceProcessor>(this);
+    SignificanceProcessor->Initialize(*this);
+}
+
+void UAICrowdSubsystem::Deinitialize()
+{
+    PromotedEntities.Reset();
+    NumEntities = 0;
+    SET_DWORD_STAT(STAT_MPAI_CrowdPromoted, 0);
+
+    Super::Deinitialize();
+}
+
+FMassEntityManager* UAICrowdSubsystem::GetEntityManager() const
+{
+    UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>();
+    return EntitySubsystem ? &EntitySubsystem->GetMutableEntityManager() : nullptr;
+}
+
+void UAICrowdSubsystem::SpawnEntities(AEnemySpawner* Spawner, TConstArrayView<FEnemySpawnData> SpawnEntries)
+{
+    FMassEntityManager* EntityManager = GetEntityManager();
+    if (!EntityManager || !Spawner)
+    {
+        return;
+    }
+
+    if (!EntityArchetype.IsValid())
+    {
+        EntityArchetype = EntityManager->CreateArchetype({
+            FAICrowdTransformFragment::StaticStruct(),
+            FAICrowdHealthFragment::StaticStruct(),
+            FAICrowdRepresentationFragment::StaticStruct()
+        });
+    }
+
+    TMap<UCharacterDataAsset*, TArray<int32>> EntriesByArchetype;
+    for (int32 EntryIndex = 0; EntryIndex < SpawnEntries.Num(); ++EntryIndex)
+    {
+        if (SpawnEntries[EntryIndex].EnemyDataAsset)
+        {
+            EntriesByArchetype.FindOrAdd(SpawnEntries[EntryIndex].EnemyDataAsset).Add(EntryIndex);
+        }
+    }
+
+    for (const TPair<UCharacterDataAsset*, TArray<int32>>& Pair : EntriesByArchetype)
+    {
+        FAICrowdArchetypeFragment ArchetypeFragment;
+        ArchetypeFragment.DataAsset = Pair.Key;
+        ArchetypeFragment.Spawner = Spawner;
+
+        FMassArchetypeSharedFragmentValues SharedValues;
+        SharedValues.AddConstSharedFragment(EntityManager->GetOrCreateConstSharedFragment(ArchetypeFragment));
+        SharedValues.Sort();
+
+        TArray<FMassEntityHandle> Entities;
+        TSharedRef<FMassEntityManager::FEntityCreationContext> CreationContext =
+            EntityManager->BatchCreateEntities(EntityArchetype, SharedValues, Pair.Value.Num(), Entities);
+
+        for (int32 Index = 0; Index < Entities.Num(); ++Index)
+        {
+            const FEnemySpawnData& Entry = SpawnEntries[Pair.Value[Index]];
+
+            EntityManager->GetFragmentDataChecked<FAICrowdTransformFragment>(Entities[Index]).Transform = Entry.SpawnTransform;
+
+            FAICrowdRepresentationFragment& Representation = EntityManager->GetFragmentDataChecked<FAICrowdRepresentationFragment>(Entities[Index]);
+            Representation.SquadId = Entry.SquadId;
+            Representation.State = Pair.Key->DefaultStartState;
+
+            FAICrowdHealthFragment& Health = EntityManager->GetFragmentDataChecked<FAICrowdHealthFragment>(Entities[Index]);
+            Health.MaxHealth = Pair.Key->MaxHealth;
+            Health.CurrentHealth = Pair.Key->MaxHealth;
+        }
+
+        NumEntities += Entities.Num();
+        INC_DWORD_STAT_BY(STAT_MPAI_CrowdEntities, Entities.Num());
+    }
+}
+
+void UAICrowdSubsystem::DestroyEntities(const AEnemySpawner* Spawner)
+{
+    FMassEntityManager* EntityManager = GetEntityManager();
+    if (!EntityManager || !EntityArchetype.IsValid())
+    {
+        return;
+    }
+
+    TArray<FMassEntityHandle> Entities;
+    FMassEntityQuery Query;
+    Query.AddRequirement<FAICrowdRepresentationFragment>(EMassFragmentAccess::ReadOnly);
+    Query.AddConstSharedRequirement<FAICrowdArchetypeFragment>();
+
+    FMassExecutionContext Context(*EntityManager);
+    Query.ForEachEntityChunk(*EntityManager, Context, [Spawner, &Entities](FMassExecutionContext& ChunkContext)
+    {
+        if (ChunkContext.GetConstSharedFragment<FAICrowdArchetypeFragment>().Spawner == Spawner)
+        {
+            for (int32 Index = 0; Index < ChunkContext.GetNumEntities(); ++Index)
+            {
+                Entities.Add(ChunkContext.GetEntity(Index));
+            }
+        }
+    });
+
+    for (auto It = PromotedEntities.CreateIterator(); It; ++It)
+    {
+        if (Entities.Contains(It.Value()))
+        {
+            It.RemoveCurrent();
+        }
+    }
+
+    EntityManager->BatchDestroyEntities(Entities);
+    NumEntities -= Entities.Num();
+    DEC_DWORD_STAT_BY(STAT_MPAI_CrowdEntities, Entities.Num());
+}
+
+void UAICrowdSubsystem::HandlePromotedEnemyDied(ACharacter* Enemy)
+{
+    FMassEntityHandle Entity;
+    if (!PromotedEntities.RemoveAndCopyValue(MakeWeakObjectPtr<const AActor>(Enemy), Entity))
+    {
+        return;
+    }
+
+    FMassEntityManager* EntityManager = GetEntityManager();
+    if (EntityManager && EntityManager->IsEntityValid(Entity))
+    {
+        EntityManager->DestroyEntity(Entity);
+        --NumEntities;
+        DEC_DWORD_STAT(STAT_MPAI_CrowdEntities);
+    }
+}
+
+void UAICrowdSubsystem::Tick(float DeltaTime)
+{
+    MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_CrowdUpdate);
+
+    FMassEntityManager* EntityManager = GetEntityManager();
+    if (!EntityManager || NumEntities == 0)
+    {
+        return;
+    }
+
+    SyncPromotedTransforms(*EntityManager);
+
+    SignificanceProcessor->SourceLocations.Reset();
+    GatherPlayerLocations(SignificanceProcessor->SourceLocations);
+    SignificanceProcessor->PromoteRadius = PromoteRadius;
+    SignificanceProcessor->DemoteRadius = DemoteRadius;
+
+    // Goes over every chunk in parallel, the game thread only handles the entities that change representation
+    FMassProcessingContext ProcessingContext(*EntityManager, DeltaTime);
+    UE::Mass::Executor::Run(*SignificanceProcessor, ProcessingContext);
+
+    for (const FMassEntityHandle Entity : SignificanceProcessor->DeadEntities)
+    {
+        EntityManager->DestroyEntity(Entity);
+    }
+    NumEntities -= SignificanceProcessor->DeadEntities.Num();
+    DEC_DWORD_STAT_BY(STAT_MPAI_CrowdEntities, SignificanceProcessor->DeadEntities.Num());
+
+    const int32 NumDemotions = FMath::Min(SignificanceProcessor->EntitiesToDemote.Num(), MaxDemotionsPerTick);
+    for (int32 Index = 0; Index < NumDemotions; ++Index)
+    {
+        DemoteEntity(*EntityManager, SignificanceProcessor->EntitiesToDemote[Index]);
+    }
+
+    const int32 NumPromotions = FMath::Min(SignificanceProcessor->EntitiesToPromote.Num(), MaxPromotionsPerTick);
+    for (int32 Index = 0; Index < NumPromotions; ++Index)
+    {
+        PromoteEntity(*EntityManager, SignificanceProcessor->EntitiesToPromote[Index]);
+    }
+
+    SET_DWORD_STAT(STAT_MPAI_CrowdPromoted, GetNumPromoted());
+}
+
+void UAICrowdSubsystem::PromoteEntity(FMassEntityManager& EntityManager, FMassEntityHandle Entity)
+{
+    const FAICrowdArchetypeFragment& Archetype = EntityManager.GetConstSharedFragmentDataChecked<FAICrowdArchetypeFragment>(Entity);
+    FAICrowdRepresentationFragment& Representation = EntityManager.GetFragmentDataChecked<FAICrowdRepresentationFragment>(Entity);
+    if (!Archetype.Spawner || !Archetype.DataAsset)
+    {
+        return;
+    }
+
+    FEnemySpawnData SpawnData;
+    SpawnData.EnemyDataAsset = Archetype.DataAsset;
+    SpawnData.SpawnTransform = EntityManager.GetFragmentDataChecked<FAICrowdTransformFragment>(Entity).Transform;
+    SpawnData.SquadId = Representation.SquadId;
+
+    // The character starts from the archetype defaults, hand it what the entity went through
+    const FAICrowdHealthFragment& Health = EntityManager.GetFragmentDataChecked<FAICrowdHealthFragment>(Entity);
+    ACharacter* Enemy = Archetype.Spawner->PromoteCrowdEnemy(SpawnData, Health.CurrentHealth, Representation.State);
+    if (!Enemy)
+    {
+        return;
+    }
+
+    Representation.Actor = Enemy;
+    Representation.bHasActor = true;
+    PromotedEntities.Add(Enemy, Entity);
+}
+
+void UAICrowdSubsystem::DemoteEntity(FMassEntityManager& EntityManager, FMassEntityHandle Entity)
+{
+    const FAICrowdArchetypeFragment& Archetype = EntityManager.GetConstSharedFragmentDataChecked<FAICrowdArchetypeFragment>(Entity);
+    FAICrowdRepresentationFragment& Representation = EntityManager.GetFragmentDataChecked<FAICrowdRepresentationFragment>(Entity);
+
+    ACharacter* Enemy = Representation.Actor.Get();
+    Representation.Actor = nullptr;
+    Representation.bHasActor = false;
+    if (!Enemy)
+    {
+        return;
+    }
+    PromotedEntities.Remove(Enemy);
+
+    EntityManager.GetFragmentDataChecked<FAICrowdTransformFragment>(Entity).Transform = Enemy->GetActorTransform();
+
+    float CurrentHealth = -1.0f;
+    if (Archetype.Spawner && Archetype.Spawner->DemoteCrowdEnemy(Enemy, CurrentHealth, Representation.State) && CurrentHealth >= 0.0f)
+    {
+        // Negative for characters without a damageable component, the entity keeps its own health then
+        EntityManager.GetFragmentDataChecked<FAICrowdHealthFragment>(Entity).CurrentHealth = CurrentHealth;
+    }
+}
+
+void UAICrowdSubsystem::SyncPromotedTransforms(FMassEntityManager& EntityManager)
+{
+    for (auto It = PromotedEntities.CreateIterator(); It; ++It)
+    {
+        // Destroyed behind our back, the entity is significant again on the next pass and gets a new character
+        const AActor* Enemy = It.Key().Get();
+        if (!Enemy || !EntityManager.IsEntityValid(It.Value()))
+        {
+            if (EntityManager.IsEntityValid(It.Value()))
+            {
+                FAICrowdRepresentationFragment& Representation = EntityManager.GetFragmentDataChecked<FAICrowdRepresentationFragment>(It.Value());
+                Representation.Actor = nullptr;
+                Representation.bHasActor = false;
+            }
+            It.RemoveCurrent();
+            continue;
+        }
+
+        EntityManager.GetFragmentDataChecked<FAICrowdTransformFragment>(It.Value()).Transform = Enemy->GetActorTransform();
+    }
+}
+
+void UAICrowdSubsystem::GatherPlayerLocations(TArray<FVector>& OutLocations) const
+{
+    for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+    {
+        const APlayerController* PlayerController = It->Get();
+        if (PlayerController)
+        {
+            FVector ViewLocation;
+            FRotator ViewRotation;
+            PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+            OutLocations.Add(ViewLocation);
+        }
+    }
+}
+
+TStatId UAICrowdSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UAICrowdSubsystem, STATGROUP_Tickables);
+}
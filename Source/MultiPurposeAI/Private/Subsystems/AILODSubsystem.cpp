@@ -0,0 +1,269 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/AILODSubsystem.h"
+#include "Data/CharacterDataAsset.h"
+#include "Diagnostics/AIStats.h"
+#include "AIController.h"
+#include "BrainComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "Perception/AIPerceptionComponent.h"
+#include "Perception/AISenseConfig.h"
+
+void UAILODSubsystem::RegisterAgent(ACharacter* Agent, AAIController* Controller, const UCharacterDataAsset* DataAsset)
+{
+    if (!Agent || !DataAsset || DataAsset->LODTiers.Num() == 0 || AgentIndices.Contains(MakeWeakObjectPtr<AActor>(Agent)))
+    {
+        return;
+    }
+
+    const int32 Index = Agents.Add(Agent);
+    AgentIndices.Add(MakeWeakObjectPtr<AActor>(Agent), Index);
+    Controllers.Add(Controller);
+    DataAssets.Add(DataAsset);
+    Locations.Add(Agent->GetActorLocation());
+    Tiers.Add(INDEX_NONE);
+
+    // Start in the right tier instead of running at full cost until the pass reaches the agent
+    if (PlayerLocations.Num() == 0)
+    {
+        GatherPlayerLocations();
+    }
+    ApplyTier(Index, ComputeTier(Index));
+}
+
+void UAILODSubsystem::UnregisterAgent(ACharacter* Agent)
+{
+    const int32* Index = AgentIndices.Find(MakeWeakObjectPtr<AActor>(Agent));
+    if (!Index)
+    {
+        return;
+    }
+
+    const TArray<FAILODTier>& LODTiers = DataAssets[*Index]->LODTiers;
+    const bool bWasDormant = LODTiers.IsValidIndex(Tiers[*Index]) && LODTiers[Tiers[*Index]].bDormant;
+
+    // Tier 0 is the closest tier, restore plain full-rate ticking rather than whatever it was configured to
+    if (Agent && Agent->GetMesh())
+    {
+        Agent->GetMesh()->SetComponentTickInterval(0.0f);
+        Agent->GetMesh()->SetComponentTickEnabled(true);
+    }
+    if (Agent && Agent->GetCharacterMovement())
+    {
+        Agent->GetCharacterMovement()->SetComponentTickInterval(0.0f);
+        Agent->GetCharacterMovement()->SetComponentTickEnabled(true);
+    }
+    if (AAIController* Controller = Controllers[*Index].Get())
+    {
+        Controller->SetActorTickInterval(0.0f);
+        if (UBrainComponent* Brain = Controller->GetBrainComponent())
+        {
+            Brain->SetComponentTickInterval(0.0f);
+
+            // Otherwise the next owner of a pooled enemy gets a brain that never runs
+            if (bWasDormant)
+            {
+                Brain->ResumeLogic(TEXT("AI LOD"));
+            }
+        }
+    }
+
+    RemoveAgentAt(*Index);
+}
+
+int32 UAILODSubsystem::GetAgentTier(const ACharacter* Agent) const
+{
+    const int32* Index = AgentIndices.Find(MakeWeakObjectPtr<AActor>(const_cast<ACharacter*>(Agent)));
+    return Index ? Tiers[*Index] : INDEX_NONE;
+}
+
+void UAILODSubsystem::RemoveAgentAt(int32 Index)
+{
+    AgentIndices.Remove(Agents[Index]);
+
+    // Swap the last agent into the hole so the arrays stay contiguous
+    const int32 LastIndex = Agents.Num() - 1;
+    if (Index != LastIndex)
+    {
+        AgentIndices.FindChecked(Agents[LastIndex]) = Index;
+    }
+
+    Agents.RemoveAtSwap(Index, 1, false);
+    Controllers.RemoveAtSwap(Index, 1, false);
+    DataAssets.RemoveAtSwap(Index, 1, false);
+    Locations.RemoveAtSwap(Index, 1, false);
+    Tiers.RemoveAtSwap(Index, 1, false);
+}
+
+void UAILODSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    if (Agents.Num() == 0)
+    {
+        return;
+    }
+
+    MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_LODPass);
+
+    GatherPlayerLocations();
+
+    const int32 NumToVisit = FMath::Min(FMath::Max(AgentsPerTick, 1), Agents.Num());
+
+    // Refresh the slice's locations first, then the distance tests only read flat arrays
+    int32 NumVisited = 0;
+    while (NumVisited < NumToVisit && Agents.Num() > 0)
+    {
+        if (NextAgentIndex >= Agents.Num())
+        {
+            NextAgentIndex = 0;
+        }
+
+        const ACharacter* Agent = Agents[NextAgentIndex].Get();
+        if (!Agent)
+        {
+            // Destroyed without unregistering, the swapped-in agent is visited next
+            RemoveAgentAt(NextAgentIndex);
+            continue;
+        }
+
+        Locations[NextAgentIndex] = Agent->GetActorLocation();
+
+        const int32 Tier = ComputeTier(NextAgentIndex);
+        if (Tier != Tiers[NextAgentIndex])
+        {
+            ApplyTier(NextAgentIndex, Tier);
+        }
+
+        ++NextAgentIndex;
+        ++NumVisited;
+    }
+}
+
+TStatId UAILODSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UAILODSubsystem, STATGROUP_Tickables);
+}
+
+void UAILODSubsystem::GatherPlayerLocations()
+{
+    PlayerLocations.Reset();
+
+    for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+    {
+        const APlayerController* PlayerController = It->Get();
+        if (PlayerController)
+        {
+            FVector ViewLocation;
+            FRotator ViewRotation;
+            PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+            PlayerLocations.Add(ViewLocation);
+        }
+    }
+}
+
+int32 UAILODSubsystem::ComputeTier(int32 Index) const
+{
+    const TArray<FAILODTier>& LODTiers = DataAssets[Index]->LODTiers;
+
+    // No player to be far from, nothing to save
+    if (PlayerLocations.Num() == 0)
+    {
+        return 0;
+    }
+
+    float MinDistanceSquared = TNumericLimits<float>::Max();
+    for (const FVector& PlayerLocation : PlayerLocations)
+    {
+        MinDistanceSquared = FMath::Min(MinDistanceSquared, static_cast<float>(FVector::DistSquared(PlayerLocation, Locations[Index])));
+    }
+    const float Distance = FMath::Sqrt(MinDistanceSquared);
+
+    int32 Tier = LODTiers.Num() - 1;
+    for (int32 TierIndex = 0; TierIndex < LODTiers.Num(); ++TierIndex)
+    {
+        if (Distance <= LODTiers[TierIndex].MaxDistance)
+        {
+            Tier = TierIndex;
+            break;
+        }
+    }
+
+    // Stay in the current, closer tier until the agent is clearly past its border
+    const int32 CurrentTier = Tiers[Index];
+    if (LODTiers.IsValidIndex(CurrentTier) && Tier > CurrentTier && Distance <= LODTiers[CurrentTier].MaxDistance + TierHysteresis)
+    {
+        return CurrentTier;
+    }
+
+    return Tier;
+}
+
+void UAILODSubsystem::ApplyTier(int32 Index, int32 Tier)
+{
+    ACharacter* Agent = Agents[Index].Get();
+    AAIController* Controller = Controllers[Index].Get();
+    const UCharacterDataAsset* DataAsset = DataAssets[Index];
+    if (!Agent || !DataAsset->LODTiers.IsValidIndex(Tier))
+    {
+        return;
+    }
+
+    const FAILODTier& LODTier = DataAsset->LODTiers[Tier];
+    const bool bWasDormant = DataAsset->LODTiers.IsValidIndex(Tiers[Index]) && DataAsset->LODTiers[Tiers[Index]].bDormant;
+    Tiers[Index] = Tier;
+
+    USkeletalMeshComponent* Mesh = Agent->GetMesh();
+    if (Mesh)
+    {
+        Mesh->SetComponentTickInterval(LODTier.AnimationTickInterval);
+        Mesh->SetComponentTickEnabled(!LODTier.bDormant);
+    }
+
+    UCharacterMovementComponent* Movement = Agent->GetCharacterMovement();
+    if (Movement)
+    {
+        Movement->SetComponentTickInterval(LODTier.LogicTickInterval);
+        Movement->SetComponentTickEnabled(!LODTier.bDormant);
+    }
+
+    if (!Controller)
+    {
+        return;
+    }
+
+    Controller->SetActorTickInterval(LODTier.LogicTickInterval);
+
+    UBrainComponent* Brain = Controller->GetBrainComponent();
+    if (Brain)
+    {
+        Brain->SetComponentTickInterval(LODTier.LogicTickInterval);
+        if (LODTier.bDormant && !bWasDormant)
+        {
+            Brain->PauseLogic(TEXT("AI LOD"));
+        }
+        else if (!LODTier.bDormant && bWasDormant)
+        {
+            Brain->ResumeLogic(TEXT("AI LOD"));
+        }
+    }
+
+    UAIPerceptionComponent* Perception = Controller->GetPerceptionComponent();
+    const TArray<FCompiledLODTier>& CompiledTiers = DataAsset->GetCompiledArchetype().LODTiers;
+    if (Perception && CompiledTiers.IsValidIndex(Tier))
+    {
+        const bool bPerceive = LODTier.bEnablePerception && !LODTier.bDormant;
+        for (const TObjectPtr<UAISenseConfig>& SenseConfig : CompiledTiers[Tier].SenseConfigs)
+        {
+            // Reconfiguring a sense replaces the config of the same class, the ranges follow the tier
+            Perception->ConfigureSense(*SenseConfig);
+            Perception->SetSenseEnabled(SenseConfig->GetSenseImplementation(), bPerceive);
+        }
+        Perception->RequestStimuliListenerUpdate();
+    }
+}
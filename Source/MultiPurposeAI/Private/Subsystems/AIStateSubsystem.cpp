@@ -0,0 +1,211 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/AIStateSubsystem.h"
+#include "Subsystems/BlackboardWriteSubsystem.h"
+#include "Diagnostics/AIStats.h"
+#include "Engine/World.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Enum.h"
+
+void UAIStateSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+    BlackboardWriter = Collection.InitializeDependency<UBlackboardWriteSubsystem>();
+}
+
+int32 UAIStateSubsystem::RegisterAgent(AActor* Agent, EAICharacterState InitialState)
+{
+    int32 Handle;
+    if (FreeHandles.Num() > 0)
+    {
+        Handle = FreeHandles.Pop(false);
+    }
+    else
+    {
+        Handle = States.AddDefaulted();
+        PreviousStates.AddDefaulted();
+        StateEnterTimes.AddDefaulted();
+        Agents.AddDefaulted();
+        Blackboards.AddDefaulted();
+        AIStateKeys.AddDefaulted();
+        AllocatedSlots.Add(false);
+        DirtyMirrorFlags.Add(false);
+    }
+
+    States[Handle] = InitialState;
+    PreviousStates[Handle] = EAICharacterState::None;
+    StateEnterTimes[Handle] = GetWorldTime();
+    Agents[Handle] = Agent;
+    Blackboards[Handle] = nullptr;
+    AIStateKeys[Handle] = FBlackboard::InvalidKey;
+    AllocatedSlots[Handle] = true;
+
+    const int32 StateIndex = static_cast<int32>(InitialState);
+    if (StateIndex >= StateCounts.Num())
+    {
+        StateCounts.SetNumZeroed(StateIndex + 1);
+    }
+    ++StateCounts[StateIndex];
+
+    return Handle;
+}
+
+void UAIStateSubsystem::UnregisterAgent(int32 Handle)
+{
+    if (!IsValidHandle(Handle))
+    {
+        return;
+    }
+
+    --StateCounts[static_cast<int32>(States[Handle])];
+
+    Agents[Handle] = nullptr;
+    Blackboards[Handle] = nullptr;
+    AllocatedSlots[Handle] = false;
+    FreeHandles.Add(Handle);
+}
+
+bool UAIStateSubsystem::IsValidHandle(int32 Handle) const
+{
+    return AllocatedSlots.IsValidIndex(Handle) && AllocatedSlots[Handle];
+}
+
+EAICharacterState UAIStateSubsystem::GetState(int32 Handle) const
+{
+    return IsValidHandle(Handle) ? States[Handle] : EAICharacterState::None;
+}
+
+EAICharacterState UAIStateSubsystem::GetPreviousState(int32 Handle) const
+{
+    return IsValidHandle(Handle) ? PreviousStates[Handle] : EAICharacterState::None;
+}
+
+float UAIStateSubsystem::GetTimeInState(int32 Handle) const
+{
+    return IsValidHandle(Handle) ? static_cast<float>(GetWorldTime() - StateEnterTimes[Handle]) : 0.0f;
+}
+
+bool UAIStateSubsystem::SetState(int32 Handle, EAICharacterState NewState)
+{
+    if (!IsValidHandle(Handle) || States[Handle] == NewState)
+    {
+        return false;
+    }
+
+    --StateCounts[static_cast<int32>(States[Handle])];
+
+    const int32 StateIndex = static_cast<int32>(NewState);
+    if (StateIndex >= StateCounts.Num())
+    {
+        StateCounts.SetNumZeroed(StateIndex + 1);
+    }
+    ++StateCounts[StateIndex];
+
+    PreviousStates[Handle] = States[Handle];
+    States[Handle] = NewState;
+    StateEnterTimes[Handle] = GetWorldTime();
+    INC_DWORD_STAT(STAT_MPAI_StateChanges);
+
+    if (Blackboards[Handle].IsValid() && !DirtyMirrorFlags[Handle])
+    {
+        DirtyMirrorFlags[Handle] = true;
+        DirtyMirrors.Add(Handle);
+    }
+
+    return true;
+}
+
+void UAIStateSubsystem::SetBlackboardMirror(int32 Handle, UBlackboardComponent* Blackboard, FBlackboard::FKey AIStateKey)
+{
+    if (!IsValidHandle(Handle))
+    {
+        return;
+    }
+
+    Blackboards[Handle] = Blackboard;
+    AIStateKeys[Handle] = AIStateKey;
+
+    // The new blackboard has not seen the current state yet
+    if (Blackboard && !DirtyMirrorFlags[Handle])
+    {
+        DirtyMirrorFlags[Handle] = true;
+        DirtyMirrors.Add(Handle);
+    }
+}
+
+int32 UAIStateSubsystem::CountAgentsInState(EAICharacterState State) const
+{
+    const int32 StateIndex = static_cast<int32>(State);
+    return StateCounts.IsValidIndex(StateIndex) ? StateCounts[StateIndex] : 0;
+}
+
+void UAIStateSubsystem::GetAgentsInState(EAICharacterState State, TArray<AActor*>& OutAgents) const
+{
+    OutAgents.Reset(CountAgentsInState(State));
+
+    for (int32 Handle = 0; Handle < States.Num(); ++Handle)
+    {
+        if (States[Handle] == State && AllocatedSlots[Handle])
+        {
+            if (AActor* Agent = Agents[Handle].Get())
+            {
+                OutAgents.Add(Agent);
+            }
+        }
+    }
+}
+
+void UAIStateSubsystem::FlushBlackboardMirror()
+{
+    for (const int32 Handle : DirtyMirrors)
+    {
+        DirtyMirrorFlags[Handle] = false;
+
+        if (!AllocatedSlots[Handle])
+        {
+            continue;
+        }
+
+        UBlackboardComponent* Blackboard = Blackboards[Handle].Get();
+        if (!Blackboard)
+        {
+            continue;
+        }
+
+        if (BlackboardWriter)
+        {
+            BlackboardWriter->SetEnum(Blackboard, AIStateKeys[Handle], static_cast<uint8>(States[Handle]));
+        }
+        else
+        {
+            Blackboard->SetValue<UBlackboardKeyType_Enum>(AIStateKeys[Handle], static_cast<uint8>(States[Handle]));
+        }
+    }
+
+    DirtyMirrors.Reset();
+
+    // Tick order between the two subsystems is not defined, don't let the state reach the blackboard a frame late
+    if (BlackboardWriter)
+    {
+        BlackboardWriter->Flush();
+    }
+}
+
+void UAIStateSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    FlushBlackboardMirror();
+}
+
+TStatId UAIStateSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UAIStateSubsystem, STATGROUP_Tickables);
+}
+
+double UAIStateSubsystem::GetWorldTime() const
+{
+    const UWorld* World = GetWorld();
+    return World ? World->GetTimeSeconds() : 0.0;
+}
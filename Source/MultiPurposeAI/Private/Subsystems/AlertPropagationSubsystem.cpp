@@ -0,0 +1,246 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/AlertPropagationSubsystem.h"
+#include "Components/StateManagerComponent.h"
+
+void UAlertPropagationSubsystem::RegisterAgent(AActor* Agent, UStateManagerComponent* StateManager, EAICharacterState AlertState, const UObject* SquadOwner, int32 SquadId)
+{
+    if (!Agent)
+    {
+        return;
+    }
+
+    const FSquadKey Squad(FObjectKey(SquadOwner), SquadId);
+
+    if (const int32* ExistingIndex = AgentIndices.Find(MakeWeakObjectPtr(Agent)))
+    {
+        // Re-registration after a respawn, only the settings may have changed
+        const int32 Index = *ExistingIndex;
+        StateManagers[Index] = StateManager;
+        AlertStates[Index] = AlertState;
+        if (Squads[Index] != Squad)
+        {
+            RemoveSquadMember(Squads[Index], Index);
+            Squads[Index] = Squad;
+            AddSquadMember(Squad, Index);
+        }
+        return;
+    }
+
+    const int32 Index = Agents.Num();
+    AgentIndices.Add(MakeWeakObjectPtr(Agent), Index);
+    Agents.Add(Agent);
+    StateManagers.Add(StateManager);
+    AlertStates.Add(AlertState);
+    Squads.Add(Squad);
+    Locations.Add(Agent->GetActorLocation());
+    AddSquadMember(Squad, Index);
+}
+
+void UAlertPropagationSubsystem::UnregisterAgent(AActor* Agent)
+{
+    const int32* Index = AgentIndices.Find(MakeWeakObjectPtr(Agent));
+    if (Index)
+    {
+        RemoveAgentAt(*Index);
+    }
+}
+
+void UAlertPropagationSubsystem::RemoveAgentAt(int32 Index)
+{
+    AgentIndices.Remove(Agents[Index]);
+    RemoveSquadMember(Squads[Index], Index);
+
+    // Swap the last agent into the hole so the arrays stay contiguous
+    const int32 LastIndex = Agents.Num() - 1;
+    if (Index != LastIndex)
+    {
+        AgentIndices.FindChecked(Agents[LastIndex]) = Index;
+        if (TArray<int32>* Members = SquadMembers.Find(Squads[LastIndex]))
+        {
+            Members->Remove(LastIndex);
+            Members->Add(Index);
+        }
+    }
+
+    Agents.RemoveAtSwap(Index, 1, false);
+    StateManagers.RemoveAtSwap(Index, 1, false);
+    AlertStates.RemoveAtSwap(Index, 1, false);
+    Squads.RemoveAtSwap(Index, 1, false);
+    Locations.RemoveAtSwap(Index, 1, false);
+}
+
+void UAlertPropagationSubsystem::AddSquadMember(const FSquadKey& Squad, int32 Index)
+{
+    if (Squad.Value != INDEX_NONE)
+    {
+        SquadMembers.FindOrAdd(Squad).Add(Index);
+    }
+}
+
+void UAlertPropagationSubsystem::RemoveSquadMember(const FSquadKey& Squad, int32 Index)
+{
+    TArray<int32>* Members = SquadMembers.Find(Squad);
+    if (!Members)
+    {
+        return;
+    }
+
+    Members->RemoveSingleSwap(Index, false);
+    if (Members->Num() == 0)
+    {
+        SquadMembers.Remove(Squad);
+    }
+}
+
+void UAlertPropagationSubsystem::RaiseAlert(AActor* Source, float Radius, EAICharacterState State)
+{
+    if (!Source)
+    {
+        return;
+    }
+
+    const int32* SourceIndex = AgentIndices.Find(MakeWeakObjectPtr(Source));
+
+    FPendingAlert& Alert = PendingAlerts.AddDefaulted_GetRef();
+    Alert.Origin = Source->GetActorLocation();
+    Alert.Radius = Radius;
+    Alert.Squad = SourceIndex ? Squads[*SourceIndex] : FSquadKey(FObjectKey(), INDEX_NONE);
+    Alert.State = State;
+}
+
+void UAlertPropagationSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    if (PendingAlerts.Num() == 0)
+    {
+        return;
+    }
+
+    RebuildGrid();
+    PendingStates.Init(EAICharacterState::None, Agents.Num());
+
+    for (const FPendingAlert& Alert : PendingAlerts)
+    {
+        if (Alert.Radius > 0.0f)
+        {
+            AlertRadius(Alert);
+        }
+
+        if (const TArray<int32>* Members = Alert.Squad.Value != INDEX_NONE ? SquadMembers.Find(Alert.Squad) : nullptr)
+        {
+            for (const int32 Index : *Members)
+            {
+                PendingStates[Index] = Alert.State != EAICharacterState::None ? Alert.State : AlertStates[Index];
+            }
+        }
+    }
+
+    PendingAlerts.Reset();
+
+    for (int32 Index = 0; Index < PendingStates.Num(); ++Index)
+    {
+        if (PendingStates[Index] != EAICharacterState::None)
+        {
+            ApplyAlertState(Index, PendingStates[Index]);
+        }
+    }
+}
+
+TStatId UAlertPropagationSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UAlertPropagationSubsystem, STATGROUP_Tickables);
+}
+
+void UAlertPropagationSubsystem::AlertRadius(const FPendingAlert& Alert)
+{
+    const float RadiusSquared = FMath::Square(Alert.Radius);
+    const FIntVector MinCell = GetCell(Alert.Origin - FVector(Alert.Radius));
+    const FIntVector MaxCell = GetCell(Alert.Origin + FVector(Alert.Radius));
+
+    auto AlertCell = [this, &Alert, RadiusSquared](const TArray<int32>& Cell)
+    {
+        for (const int32 Index : Cell)
+        {
+            if (FVector::DistSquared(Locations[Index], Alert.Origin) <= RadiusSquared)
+            {
+                PendingStates[Index] = Alert.State != EAICharacterState::None ? Alert.State : AlertStates[Index];
+            }
+        }
+    };
+
+    // A radius spanning more cells than are occupied walks the occupied ones instead of looking up empty space
+    const int64 NumCellsInRange = static_cast<int64>(MaxCell.X - MinCell.X + 1) * (MaxCell.Y - MinCell.Y + 1) * (MaxCell.Z - MinCell.Z + 1);
+    if (NumCellsInRange > Grid.Num())
+    {
+        for (const TPair<FIntVector, TArray<int32>>& Pair : Grid)
+        {
+            const FIntVector& Cell = Pair.Key;
+            if (Cell.X >= MinCell.X && Cell.X <= MaxCell.X && Cell.Y >= MinCell.Y && Cell.Y <= MaxCell.Y && Cell.Z >= MinCell.Z && Cell.Z <= MaxCell.Z)
+            {
+                AlertCell(Pair.Value);
+            }
+        }
+        return;
+    }
+
+    for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+    {
+        for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+        {
+            for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+            {
+                if (const TArray<int32>* Cell = Grid.Find(FIntVector(X, Y, Z)))
+                {
+                    AlertCell(*Cell);
+                }
+            }
+        }
+    }
+}
+
+FIntVector UAlertPropagationSubsystem::GetCell(const FVector& Location) const
+{
+    const float CellSize = FMath::Max(GridCellSize, 1.0f);
+    return FIntVector(
+        FMath::FloorToInt(Location.X / CellSize),
+        FMath::FloorToInt(Location.Y / CellSize),
+        FMath::FloorToInt(Location.Z / CellSize));
+}
+
+void UAlertPropagationSubsystem::RebuildGrid()
+{
+    // Keep the cell arrays allocated between frames, agents mostly stay in the same cells
+    for (TPair<FIntVector, TArray<int32>>& Pair : Grid)
+    {
+        Pair.Value.Reset();
+    }
+
+    // Drop agents destroyed without unregistering first, indices must be stable while bucketing
+    for (int32 Index = Agents.Num() - 1; Index >= 0; --Index)
+    {
+        if (!Agents[Index].IsValid())
+        {
+            RemoveAgentAt(Index);
+        }
+    }
+
+    for (int32 Index = 0; Index < Agents.Num(); ++Index)
+    {
+        const AActor* Agent = Agents[Index].Get();
+        Locations[Index] = Agent->GetActorLocation();
+        Grid.FindOrAdd(GetCell(Locations[Index])).Add(Index);
+    }
+}
+
+void UAlertPropagationSubsystem::ApplyAlertState(int32 AgentIndex, EAICharacterState State)
+{
+    // Goes through the agent's transition table, real changes are mirrored into its blackboard
+    UStateManagerComponent* StateManager = StateManagers[AgentIndex].Get();
+    if (StateManager)
+    {
+        StateManager->RequestStateChange(State);
+    }
+}
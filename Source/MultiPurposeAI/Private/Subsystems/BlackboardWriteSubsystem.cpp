@@ -0,0 +1,181 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/BlackboardWriteSubsystem.h"
+#include "Diagnostics/AIDiagnostics.h"
+#include "Diagnostics/AIStats.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Enum.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
+
+bool UBlackboardWriteSubsystem::SetEnum(UBlackboardComponent* Blackboard, FBlackboard::FKey KeyID, uint8 Value)
+{
+    if (!Blackboard || KeyID == FBlackboard::InvalidKey)
+    {
+        return false;
+    }
+
+    FPendingWrite Write;
+    Write.KeyID = KeyID;
+    Write.Type = EWriteType::Enum;
+    Write.EnumValue = Value;
+    return QueueWrite(*Blackboard, Write);
+}
+
+bool UBlackboardWriteSubsystem::SetObject(UBlackboardComponent* Blackboard, FBlackboard::FKey KeyID, UObject* Value)
+{
+    if (!Blackboard || KeyID == FBlackboard::InvalidKey)
+    {
+        return false;
+    }
+
+    FPendingWrite Write;
+    Write.KeyID = KeyID;
+    Write.Type = EWriteType::Object;
+    Write.ObjectValue = Value;
+    return QueueWrite(*Blackboard, Write);
+}
+
+bool UBlackboardWriteSubsystem::QueueWrite(UBlackboardComponent& Blackboard, const FPendingWrite& Write)
+{
+    const int32* BatchIndex = BatchIndices.Find(&Blackboard);
+    if (BatchIndex)
+    {
+        for (FPendingWrite& Pending : Batches[*BatchIndex].Writes)
+        {
+            if (Pending.KeyID == Write.KeyID)
+            {
+                // Only the last value written before the flush reaches the blackboard
+                Pending = Write;
+                MPAI_COUNT(BlackboardWritesSuppressed);
+                INC_DWORD_STAT(STAT_MPAI_BlackboardWritesSuppressed);
+                return true;
+            }
+        }
+    }
+
+    if (HoldsValue(Blackboard, Write))
+    {
+        MPAI_COUNT(BlackboardWritesSuppressed);
+        INC_DWORD_STAT(STAT_MPAI_BlackboardWritesSuppressed);
+        return false;
+    }
+
+    int32 WriteBatchIndex;
+    if (BatchIndex)
+    {
+        WriteBatchIndex = *BatchIndex;
+    }
+    else
+    {
+        WriteBatchIndex = Batches.AddDefaulted();
+        Batches[WriteBatchIndex].Blackboard = &Blackboard;
+        BatchIndices.Add(&Blackboard, WriteBatchIndex);
+    }
+
+    Batches[WriteBatchIndex].Writes.Add(Write);
+    return true;
+}
+
+bool UBlackboardWriteSubsystem::HoldsValue(const UBlackboardComponent& Blackboard, const FPendingWrite& Write)
+{
+    if (Write.Type == EWriteType::Enum)
+    {
+        return Blackboard.GetValue<UBlackboardKeyType_Enum>(Write.KeyID) == Write.EnumValue;
+    }
+    return Blackboard.GetValue<UBlackboardKeyType_Object>(Write.KeyID) == Write.ObjectValue.Get();
+}
+
+void UBlackboardWriteSubsystem::FlushBlackboard(UBlackboardComponent* Blackboard)
+{
+    int32 BatchIndex;
+    if (!Blackboard || !BatchIndices.RemoveAndCopyValue(Blackboard, BatchIndex))
+    {
+        return;
+    }
+
+    FWriteBatch Batch = MoveTemp(Batches[BatchIndex]);
+    Batches.RemoveAtSwap(BatchIndex, 1, false);
+    if (Batches.IsValidIndex(BatchIndex))
+    {
+        BatchIndices[Batches[BatchIndex].Blackboard] = BatchIndex;
+    }
+
+    ApplyBatch(Batch);
+}
+
+void UBlackboardWriteSubsystem::Flush()
+{
+    if (Batches.Num() == 0)
+    {
+        return;
+    }
+
+    MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_BlackboardFlush);
+
+    Swap(Batches, FlushingBatches);
+    BatchIndices.Reset();
+
+    for (FWriteBatch& Batch : FlushingBatches)
+    {
+        ApplyBatch(Batch);
+    }
+
+    FlushingBatches.Reset();
+}
+
+void UBlackboardWriteSubsystem::ApplyBatch(FWriteBatch& Batch)
+{
+    UBlackboardComponent* Blackboard = Batch.Blackboard.Get();
+    if (!Blackboard)
+    {
+        return;
+    }
+
+    // The key may have been set back to its old value, or written by a task, since the write was queued
+    const int32 NumQueued = Batch.Writes.Num();
+    Batch.Writes.RemoveAll([Blackboard](const FPendingWrite& Write)
+    {
+        return HoldsValue(*Blackboard, Write);
+    });
+    MPAI_COUNT_N(BlackboardWritesSuppressed, NumQueued - Batch.Writes.Num());
+    INC_DWORD_STAT_BY(STAT_MPAI_BlackboardWritesSuppressed, NumQueued - Batch.Writes.Num());
+
+    // Observers are notified once every key holds its final value
+    const bool bPauseNotifications = Batch.Writes.Num() > 1;
+    if (bPauseNotifications)
+    {
+        Blackboard->PauseObserverNotifications();
+    }
+
+    for (const FPendingWrite& Write : Batch.Writes)
+    {
+        if (Write.Type == EWriteType::Enum)
+        {
+            Blackboard->SetValue<UBlackboardKeyType_Enum>(Write.KeyID, Write.EnumValue);
+        }
+        else
+        {
+            Blackboard->SetValue<UBlackboardKeyType_Object>(Write.KeyID, Write.ObjectValue.Get());
+        }
+    }
+
+    if (bPauseNotifications)
+    {
+        Blackboard->ResumeObserverNotifications(true);
+    }
+
+    MPAI_COUNT_N(BlackboardWritesApplied, Batch.Writes.Num());
+}
+
+void UBlackboardWriteSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    Flush();
+}
+
+TStatId UBlackboardWriteSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UBlackboardWriteSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/DamageQueueSubsystem.h"
+#include "Components/DamageableComponent.h"
+#include "Diagnostics/AIDiagnostics.h"
+#include "Diagnostics/AIStats.h"
+#include "Async/ParallelFor.h"
+
+int32 UDamageQueueSubsystem::RegisterTarget(UDamageableComponent* Component, float InMaxHealth, float InCurrentHealth)
+{
+    int32 Handle;
+    if (FreeHandles.Num() > 0)
+    {
+        Handle = FreeHandles.Pop(false);
+    }
+    else
+    {
+        Handle = CurrentHealth.AddDefaulted();
+        MaxHealth.AddDefaulted();
+        PendingDamage.AddDefaulted();
+        Components.AddDefaulted();
+        AllocatedSlots.Add(false);
+        DirtyFlags.Add(false);
+    }
+
+    CurrentHealth[Handle] = InCurrentHealth;
+    MaxHealth[Handle] = InMaxHealth;
+    PendingDamage[Handle] = 0.0f;
+    Components[Handle] = Component;
+    AllocatedSlots[Handle] = true;
+
+    if (Component && Component->GetOwner())
+    {
+        TargetHandles.Add(MakeWeakObjectPtr(Component->GetOwner()), Handle);
+    }
+
+    return Handle;
+}
+
+void UDamageQueueSubsystem::UnregisterTarget(int32 Handle)
+{
+    if (!IsValidHandle(Handle))
+    {
+        return;
+    }
+
+    UDamageableComponent* Component = Components[Handle].Get();
+    if (Component && Component->GetOwner())
+    {
+        TargetHandles.Remove(MakeWeakObjectPtr(Component->GetOwner()));
+    }
+
+    // Still listed in DirtyHandles, resolving 0 damage on a free slot is harmless
+    PendingDamage[Handle] = 0.0f;
+    Components[Handle] = nullptr;
+    AllocatedSlots[Handle] = false;
+    FreeHandles.Add(Handle);
+}
+
+bool UDamageQueueSubsystem::IsValidHandle(int32 Handle) const
+{
+    return AllocatedSlots.IsValidIndex(Handle) && AllocatedSlots[Handle];
+}
+
+float UDamageQueueSubsystem::GetCurrentHealth(int32 Handle) const
+{
+    return IsValidHandle(Handle) ? CurrentHealth[Handle] : 0.0f;
+}
+
+float UDamageQueueSubsystem::GetMaxHealth(int32 Handle) const
+{
+    return IsValidHandle(Handle) ? MaxHealth[Handle] : 0.0f;
+}
+
+void UDamageQueueSubsystem::SetMaxHealth(int32 Handle, float InMaxHealth)
+{
+    if (IsValidHandle(Handle))
+    {
+        MaxHealth[Handle] = InMaxHealth;
+    }
+}
+
+void UDamageQueueSubsystem::SetCurrentHealth(int32 Handle, float Health)
+{
+    if (IsValidHandle(Handle))
+    {
+        CurrentHealth[Handle] = Health;
+        PendingDamage[Handle] = 0.0f;
+    }
+}
+
+void UDamageQueueSubsystem::QueueDamage(int32 Handle, float Damage)
+{
+    // Dead characters waiting in a pool must not die a second time
+    if (Damage <= 0.0f || !IsValidHandle(Handle) || CurrentHealth[Handle] <= 0.0f)
+    {
+        return;
+    }
+
+    MPAI_COUNT(DamageEvents);
+    PendingDamage[Handle] += Damage;
+
+    if (!DirtyFlags[Handle])
+    {
+        DirtyFlags[Handle] = true;
+        DirtyHandles.Add(Handle);
+    }
+}
+
+void UDamageQueueSubsystem::QueueAreaDamage(const TArray<AActor*>& Targets, float Damage)
+{
+    for (AActor* Target : Targets)
+    {
+        const int32* Handle = TargetHandles.Find(MakeWeakObjectPtr(Target));
+        if (Handle)
+        {
+            QueueDamage(*Handle, Damage);
+        }
+    }
+}
+
+void UDamageQueueSubsystem::ProcessPendingDamage()
+{
+    if (DirtyHandles.Num() == 0)
+    {
+        return;
+    }
+
+    MPAI_SCOPE_CYCLE_COUNTER(STAT_MPAI_ProcessDamage);
+
+    DiedThisFrame.SetNumUninitialized(DirtyHandles.Num());
+
+    // Every dirty handle is unique, so each iteration only touches its own slot
+    auto ResolveDamage = [this](int32 Index)
+    {
+        const int32 Handle = DirtyHandles[Index];
+        const float HealthBefore = CurrentHealth[Handle];
+        const float HealthAfter = FMath::Max(HealthBefore - PendingDamage[Handle], 0.0f);
+
+        CurrentHealth[Handle] = HealthAfter;
+        PendingDamage[Handle] = 0.0f;
+        DiedThisFrame[Index] = HealthBefore > 0.0f && HealthAfter <= 0.0f;
+    };
+
+    if (DirtyHandles.Num() >= ParallelThreshold)
+    {
+        ParallelFor(DirtyHandles.Num(), ResolveDamage);
+    }
+    else
+    {
+        for (int32 Index = 0; Index < DirtyHandles.Num(); ++Index)
+        {
+            ResolveDamage(Index);
+        }
+    }
+
+    DeadActors.Reset();
+    DeadComponents.Reset();
+    for (int32 Index = 0; Index < DirtyHandles.Num(); ++Index)
+    {
+        const int32 Handle = DirtyHandles[Index];
+        DirtyFlags[Handle] = false;
+
+        UDamageableComponent* Component = Components[Handle].Get();
+        if (DiedThisFrame[Index] && AllocatedSlots[Handle] && Component && Component->GetOwner())
+        {
+            DeadActors.Add(Component->GetOwner());
+            DeadComponents.Add(Component);
+        }
+    }
+    DirtyHandles.Reset();
+
+    if (DeadActors.Num() == 0)
+    {
+        return;
+    }
+
+    OnAgentsDied.Broadcast(DeadActors);
+
+    // Per-component listeners and owner destruction last, the batch above saw every actor alive.
+    // Actors a listener already destroyed are skipped
+    for (const TWeakObjectPtr<UDamageableComponent>& WeakComponent : DeadComponents)
+    {
+        UDamageableComponent* Component = WeakComponent.Get();
+        if (IsValid(Component) && IsValid(Component->GetOwner()))
+        {
+            Component->HandleDeath();
+        }
+    }
+}
+
+void UDamageQueueSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    ProcessPendingDamage();
+}
+
+TStatId UDamageQueueSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UDamageQueueSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,162 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Diagnostics/AIBenchmark.h"
+#include "Data/CharacterDataAsset.h"
+#include "Components/DamageableComponent.h"
+#include "Components/StateManagerComponent.h"
+#include "Perception/AISenseConfig_Sight.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace AIBenchmarkTests
+{
+    static TAutoConsoleVariable<FString> CVarDataAsset(
+        TEXT("MultiPurposeAI.Automation.DataAsset"),
+        TEXT(""),
+        TEXT("Data asset spawned by the MultiPurposeAI automation tests, a bare ACharacter archetype when empty"));
+
+    static TAutoConsoleVariable<float> CVarBudgetScale(
+        TEXT("MultiPurposeAI.Automation.BudgetScale"),
+        1.0f,
+        TEXT("Multiplies every phase budget of the MultiPurposeAI automation tests, e.g. for slower build machines"));
+
+    /**
+     * Largest p99 a benchmark phase may reach before the test fails
+     */
+    struct FPhaseBudget
+    {
+        const TCHAR* Phase;
+        double MaxP99Ms;
+
+        // The phase has one sample for the whole batch, MaxP99Ms is per 1000 enemies with 1000 as the floor
+        bool bPerThousandEnemies;
+    };
+
+    static const FPhaseBudget PhaseBudgets[] =
+    {
+        { TEXT("Spawn"), 5.0, false },
+        { TEXT("Initialize"), 2.0, false },
+        { TEXT("PerceptionRegistration"), 100.0, true },
+        { TEXT("PerceptionSystemFrame"), 10.0, true },
+        { TEXT("PerceptionDispatch"), 0.2, false },
+        { TEXT("SnapshotSave"), 10.0, true },
+        { TEXT("SnapshotRestore"), 5000.0, true },
+        { TEXT("DamageAndDeath"), 0.5, false },
+        { TEXT("DamageQueueResolve"), 20.0, true },
+    };
+
+    /**
+     * Game world with a game mode and an AI system, destroyed with the scope
+     */
+    struct FScopedGameWorld
+    {
+        UWorld* World = nullptr;
+
+        FScopedGameWorld()
+        {
+            World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("MultiPurposeAIAutomation"));
+            FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+            WorldContext.SetCurrentWorld(World);
+
+            const FURL URL;
+            World->SetGameMode(URL);
+            World->InitializeActorsForPlay(URL);
+            World->BeginPlay();
+        }
+
+        ~FScopedGameWorld()
+        {
+            GEngine->DestroyWorldContext(World);
+            World->DestroyWorld(false);
+            CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+        }
+    };
+
+    // The data asset set in MultiPurposeAI.Automation.DataAsset, or a transient one with health, state and sight
+    static UCharacterDataAsset* GetDataAsset(FAutomationTestBase& Test)
+    {
+        const FString DataAssetPath = CVarDataAsset.GetValueOnGameThread();
+        if (!DataAssetPath.IsEmpty())
+        {
+            UCharacterDataAsset* DataAsset = LoadObject<UCharacterDataAsset>(nullptr, *DataAssetPath);
+            Test.TestNotNull(FString::Printf(TEXT("Data asset %s"), *DataAssetPath), DataAsset);
+            return DataAsset;
+        }
+
+        UCharacterDataAsset* DataAsset = NewObject<UCharacterDataAsset>(GetTransientPackage());
+        DataAsset->CharacterClass = ACharacter::StaticClass();
+        DataAsset->ComponentsToAdd = { UDamageableComponent::StaticClass(), UStateManagerComponent::StaticClass() };
+        DataAsset->MaxHealth = 100.0f;
+        DataAsset->SensesConfig.Add(NewObject<UAISenseConfig_Sight>(DataAsset));
+        return DataAsset;
+    }
+
+    static void TestPhaseBudgets(FAutomationTestBase& Test, const FAIBenchmarkRun& Run)
+    {
+        const double BudgetScale = CVarBudgetScale.GetValueOnGameThread();
+        const double Thousands = FMath::Max(Run.EnemyCount, 1000) / 1000.0;
+
+        for (const FAIBenchmarkPhase& Phase : Run.Phases)
+        {
+            for (const FPhaseBudget& Budget : PhaseBudgets)
+            {
+                if (Phase.Name != Budget.Phase)
+                {
+                    continue;
+                }
+
+                const double MaxP99Ms = Budget.MaxP99Ms * BudgetScale * (Budget.bPerThousandEnemies ? Thousands : 1.0);
+                const double P99Ms = Phase.GetPercentileMs(0.99f);
+                Test.TestTrue(FString::Printf(TEXT("%s p99 %.4f ms within its %.4f ms budget"), *Phase.Name, P99Ms, MaxP99Ms), P99Ms <= MaxP99Ms);
+            }
+        }
+    }
+}
+
+/**
+ * Runs every benchmark phase for one enemy count in a fresh game world, fails on missing enemies, survivors of lethal
+ * damage or a phase over its budget. Headless: -game -nullrhi -ExecCmds="Automation RunTests MultiPurposeAI; Quit"
+ */
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FAIBenchmarkAutomationTest, "MultiPurposeAI.Benchmark",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+void FAIBenchmarkAutomationTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+    for (const int32 EnemyCount : { 100, 1000 })
+    {
+        OutBeautifiedNames.Add(FString::Printf(TEXT("%d Enemies"), EnemyCount));
+        OutTestCommands.Add(FString::FromInt(EnemyCount));
+    }
+}
+
+bool FAIBenchmarkAutomationTest::RunTest(const FString& Parameters)
+{
+    AIBenchmarkTests::FScopedGameWorld TestWorld;
+    UCharacterDataAsset* DataAsset = AIBenchmarkTests::GetDataAsset(*this);
+    if (!DataAsset || !TestNotNull(TEXT("Character class"), DataAsset->GetCompiledArchetype().CharacterClass.Get()))
+    {
+        return false;
+    }
+
+    TArray<FAIBenchmarkRun> Results;
+    FAIBenchmarkRun& Run = Results.AddDefaulted_GetRef();
+    Run.EnemyCount = FCString::Atoi(*Parameters);
+    FAIBenchmark::RunOnce(TestWorld.World, DataAsset, Run);
+
+    TestEqual(TEXT("Spawned enemies"), Run.NumSpawned, Run.EnemyCount);
+    TestEqual(TEXT("Enemies restored from the snapshot"), Run.NumRestored, Run.NumSpawned);
+    TestEqual(TEXT("Enemies alive after lethal damage"), Run.NumSurvivedLethalDamage, 0);
+    AIBenchmarkTests::TestPhaseBudgets(*this, Run);
+
+    // Same CSV and JSON as the console command, for the build machine to archive
+    FAIBenchmark::WriteResults(DataAsset, Results, *GLog);
+    return true;
+}
+
+#endif
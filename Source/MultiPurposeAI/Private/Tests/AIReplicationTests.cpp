@@ -0,0 +1,249 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Spawner/EnemySpawner.h"
+#include "Spawner/AIAgentStateReplicator.h"
+#include "Data/CharacterDataAsset.h"
+#include "Components/DamageableComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+
+#if WITH_DEV_AUTOMATION_TESTS && WITH_EDITOR
+
+#include "Editor.h"
+#include "Settings/LevelEditorPlaySettings.h"
+#include "Tests/AutomationEditorCommon.h"
+
+namespace AIReplicationTests
+{
+    // Seconds a PIE session gets to start, and then to replicate the agent states
+    static constexpr double StartTimeout = 30.0;
+    static constexpr double ReplicationTimeout = 10.0;
+
+    /**
+     * Shared by the latent commands of one test run
+     */
+    struct FTestState
+    {
+        TStrongObjectPtr<UCharacterDataAsset> DataAsset;
+        TWeakObjectPtr<ACharacter> NearEnemy;
+        TWeakObjectPtr<ACharacter> FarEnemy;
+        double StartTime = 0.0;
+    };
+
+    static UWorld* FindPIEWorld(TFunctionRef<bool(ENetMode)> NetModePredicate)
+    {
+        for (const FWorldContext& Context : GEngine->GetWorldContexts())
+        {
+            UWorld* World = Context.World();
+            if (Context.WorldType == EWorldType::PIE && World && NetModePredicate(World->GetNetMode()))
+            {
+                return World;
+            }
+        }
+        return nullptr;
+    }
+
+    static UWorld* FindServerWorld()
+    {
+        return FindPIEWorld([](ENetMode NetMode) { return NetMode == NM_ListenServer || NetMode == NM_DedicatedServer; });
+    }
+
+    static UWorld* FindClientWorld()
+    {
+        return FindPIEWorld([](ENetMode NetMode) { return NetMode == NM_Client; });
+    }
+
+    static APlayerController* FindRemotePlayer(UWorld* ServerWorld)
+    {
+        for (FConstPlayerControllerIterator It = ServerWorld->GetPlayerControllerIterator(); It; ++It)
+        {
+            APlayerController* PlayerController = It->Get();
+            if (PlayerController && !PlayerController->IsLocalController() && PlayerController->GetPawn())
+            {
+                return PlayerController;
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename ActorType>
+    static int32 CountActors(UWorld* World)
+    {
+        int32 Count = 0;
+        for (TActorIterator<ActorType> It(World); It; ++It)
+        {
+            ++Count;
+        }
+        return Count;
+    }
+
+    static bool HasTimedOut(FAutomationTestBase* Test, const FTestState& State, double Timeout, const TCHAR* What)
+    {
+        if (FPlatformTime::Seconds() - State.StartTime < Timeout)
+        {
+            return false;
+        }
+        Test->AddError(FString::Printf(TEXT("Timed out after %.0f s waiting for %s"), Timeout, What));
+        return true;
+    }
+}
+
+/**
+ * Starts a PIE session with a listen server and a client, or a dedicated server and a client, spawns one enemy next to
+ * the client's pawn and one past its net cull distance, and checks that only the near one reaches the client's agent states
+ */
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FAIReplicationAutomationTest, "MultiPurposeAI.Replication",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+void FAIReplicationAutomationTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+    OutBeautifiedNames.Add(TEXT("Listen Server"));
+    OutTestCommands.Add(TEXT("ListenServer"));
+    OutBeautifiedNames.Add(TEXT("Dedicated Server"));
+    OutTestCommands.Add(TEXT("DedicatedServer"));
+}
+
+bool FAIReplicationAutomationTest::RunTest(const FString& Parameters)
+{
+    using namespace AIReplicationTests;
+
+    const bool bDedicatedServer = Parameters == TEXT("DedicatedServer");
+
+    FAutomationEditorCommonUtils::CreateNewMap();
+
+    // One client besides the listen server's own player, or a client of a dedicated server in the same process
+    ULevelEditorPlaySettings* PlaySettings = NewObject<ULevelEditorPlaySettings>();
+    PlaySettings->SetPlayNetMode(bDedicatedServer ? EPlayNetMode::PIE_Client : EPlayNetMode::PIE_ListenServer);
+    PlaySettings->SetPlayNumberOfClients(bDedicatedServer ? 1 : 2);
+    PlaySettings->bLaunchSeparateServer = bDedicatedServer;
+    PlaySettings->SetRunUnderOneProcess(true);
+
+    FRequestPlaySessionParams PlaySessionParams;
+    PlaySessionParams.WorldType = EPlaySessionWorldType::PlayInEditor;
+    PlaySessionParams.EditorPlaySettings = PlaySettings;
+    GEditor->RequestPlaySession(PlaySessionParams);
+
+    TSharedRef<FTestState> State = MakeShared<FTestState>();
+    State->StartTime = FPlatformTime::Seconds();
+
+    UCharacterDataAsset* DataAsset = NewObject<UCharacterDataAsset>(GetTransientPackage());
+    DataAsset->CharacterClass = ACharacter::StaticClass();
+    DataAsset->ComponentsToAdd = { UDamageableComponent::StaticClass() };
+    DataAsset->MaxHealth = 100.0f;
+    State->DataAsset.Reset(DataAsset);
+
+    // Both worlds up and the client's player possessing a pawn on the server
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, State]()
+    {
+        UWorld* ServerWorld = FindServerWorld();
+        const bool bReady = ServerWorld && FindClientWorld() && FindRemotePlayer(ServerWorld);
+        return bReady || HasTimedOut(this, *State, StartTimeout, TEXT("the PIE server and client"));
+    }));
+
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, State]()
+    {
+        UWorld* ServerWorld = FindServerWorld();
+        APlayerController* RemotePlayer = ServerWorld ? FindRemotePlayer(ServerWorld) : nullptr;
+        if (!RemotePlayer)
+        {
+            return true;
+        }
+
+        const FVector PlayerLocation = RemotePlayer->GetPawn()->GetActorLocation();
+        const float CullDistance = FMath::Sqrt(GetDefault<ACharacter>()->NetCullDistanceSquared);
+
+        AEnemySpawner* Spawner = ServerWorld->SpawnActorDeferred<AEnemySpawner>(AEnemySpawner::StaticClass(), FTransform::Identity);
+        Spawner->bValidateSpawnPoints = false;
+        Spawner->bTimeSliceSpawning = false;
+        Spawner->bUsePooling = false;
+        Spawner->ReplicationUpdateInterval = 0.1f;
+        for (const FVector& Offset : { FVector(500.0f, 0.0f, 0.0f), FVector(CullDistance * 2.0f, 0.0f, 0.0f) })
+        {
+            FEnemySpawnData& SpawnData = Spawner->EnemiesToSpawn.AddDefaulted_GetRef();
+            SpawnData.EnemyDataAsset = State->DataAsset.Get();
+            SpawnData.SpawnTransform.SetLocation(PlayerLocation + Offset);
+        }
+        Spawner->FinishSpawning(FTransform::Identity);
+
+        // The new map has no floor, falling would carry the near enemy out of range
+        for (TActorIterator<ACharacter> It(ServerWorld); It; ++It)
+        {
+            It->GetCharacterMovement()->GravityScale = 0.0f;
+            TWeakObjectPtr<ACharacter>& Enemy = FVector::Dist(It->GetActorLocation(), PlayerLocation) < CullDistance ? State->NearEnemy : State->FarEnemy;
+            Enemy = *It;
+        }
+
+        TestTrue(TEXT("Near enemy spawned"), State->NearEnemy.IsValid());
+        TestTrue(TEXT("Far enemy spawned"), State->FarEnemy.IsValid());
+        State->StartTime = FPlatformTime::Seconds();
+        return true;
+    }));
+
+    // The client ends up with exactly the near enemy, resolved to its own copy of the character
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, State, bDedicatedServer]()
+    {
+        UWorld* ServerWorld = FindServerWorld();
+        UWorld* ClientWorld = FindClientWorld();
+        if (!ServerWorld || !ClientWorld || !State->NearEnemy.IsValid() || !State->FarEnemy.IsValid())
+        {
+            return true;
+        }
+
+        TActorIterator<AAIAgentStateReplicator> ClientReplicator(ClientWorld);
+        TActorIterator<AEnemySpawner> ClientSpawner(ClientWorld);
+        const FAIAgentStateItem* ClientItem = ClientReplicator && ClientReplicator->GetAgentStates().Items.Num() > 0
+            ? &ClientReplicator->GetAgentStates().Items[0]
+            : nullptr;
+        if (!ClientSpawner || !ClientItem || !ClientItem->Agent)
+        {
+            return HasTimedOut(this, *State, ReplicationTimeout, TEXT("the near enemy's agent state on the client"));
+        }
+
+        // The listen server's own player reads the spawner directly, only the remote client gets a replicator
+        TestEqual(TEXT("Agent state replicators on the server"), CountActors<AAIAgentStateReplicator>(ServerWorld), 1);
+        TestEqual(TEXT("Agent state replicators on the client"), CountActors<AAIAgentStateReplicator>(ClientWorld), 1);
+
+        TActorIterator<AAIAgentStateReplicator> ServerReplicator(ServerWorld);
+        if (ServerReplicator)
+        {
+            TestNotNull(TEXT("Near enemy sent to the client"), ServerReplicator->GetAgentStates().FindAgent(State->NearEnemy.Get()));
+            TestNull(TEXT("Far enemy sent to the client"), ServerReplicator->GetAgentStates().FindAgent(State->FarEnemy.Get()));
+        }
+
+        TestEqual(TEXT("Agent states on the client"), ClientReplicator->GetAgentStates().Items.Num(), 1);
+        TestTrue(TEXT("Client agent state is the near enemy"),
+            FVector::Dist(ClientItem->Agent->GetActorLocation(), State->NearEnemy->GetActorLocation()) < 100.0f);
+
+        EAICharacterState ReplicatedState = EAICharacterState::None;
+        float HealthFraction = 0.0f;
+        TestTrue(TEXT("Client spawner knows the near enemy"), ClientSpawner->GetReplicatedAgentState(ClientItem->Agent, ReplicatedState, HealthFraction));
+        TestEqual(TEXT("Replicated health"), HealthFraction, 1.0f);
+
+        if (bDedicatedServer)
+        {
+            TestTrue(TEXT("Server is a dedicated server"), ServerWorld->GetNetMode() == NM_DedicatedServer);
+        }
+        return true;
+    }));
+
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([]()
+    {
+        GEditor->RequestEndPlayMap();
+        return true;
+    }));
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([]()
+    {
+        return GEditor->PlayWorld == nullptr;
+    }));
+
+    return true;
+}
+
+#endif
@@ -7,6 +7,8 @@
 #include "Interfaces/Damageable.h"
 #include "DamageableComponent.generated.h"
 
+class UDamageQueueSubsystem;
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnDeath, AActor*, DeadActor);
 
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
@@ -21,9 +23,21 @@ public:
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 private:
-    float CharacterCurrentHealth;
-    float CharacterMaxHealth;
+    // Only used while the component is not registered with a damage queue
+    float CharacterCurrentHealth = 0.0f;
+    float CharacterMaxHealth = 0.0f;
+
+    // Slot in DamageQueue, INDEX_NONE while unregistered
+    int32 DamageHandle = INDEX_NONE;
+
+    UPROPERTY(Transient)
+    TObjectPtr<UDamageQueueSubsystem> DamageQueue;
+
+    void RegisterWithDamageQueue();
+    void UnregisterFromDamageQueue();
 
 public:
     // Implement the interface functions
@@ -40,5 +54,27 @@ public:
     // **Death Delegate**
     UPROPERTY(BlueprintAssignable, Category = "Events")
     FOnDeath OnDeath;
+
+    // Health the component starts with when nobody set it before BeginPlay, e.g. baked into a prefab
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Health", meta = (ClampMin = "0"))
+    float DefaultMaxHealth = 0.0f;
+
+    // When false the owner is left alive on death so whoever listens to OnDeath can recycle it
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Events")
+    bool bDestroyOwnerOnDeath = true;
+
+    // Hits are resolved once per frame by UDamageQueueSubsystem instead of on the spot, so health and OnDeath lag
+    // behind ApplyDamage until the end of the frame. Enemies of an AEnemySpawner are opted in by the spawner
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Damage")
+    bool bUseDamageQueue = false;
+
+    // Moves the health into or out of the damage queue, hits queued and not resolved yet are dropped when leaving it
+    UFUNCTION(BlueprintCallable, Category = "Damage")
+    void SetUseDamageQueue(bool bEnable);
+
+    bool IsUsingDamageQueue() const { return DamageQueue != nullptr; }
+
+    // Broadcasts OnDeath and destroys the owner if needed, called on the spot or by the damage queue
+    void HandleDeath();
 		
 };
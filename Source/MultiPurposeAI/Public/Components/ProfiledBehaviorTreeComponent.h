@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Enums.h"
+#include "BehaviorTree/BehaviorTreeComponent.h"
+#include "ProfiledBehaviorTreeComponent.generated.h"
+
+class AAIController;
+class UCharacterDataAsset;
+class UBlackboardData;
+
+/**
+ * Behavior tree component reporting its tick time and whether the tick executed or aborted a task to FAIBehaviorTreeProfiler,
+ * under its archetype and the AIState blackboard key the tick started with.
+ * Main trees and the subtrees started by URunBehaviorTreeFromBB both run on it, so their cost lands on the state that picked them.
+ */
+UCLASS(ClassGroup = AI)
+class MULTIPURPOSEAI_API UProfiledBehaviorTreeComponent : public UBehaviorTreeComponent
+{
+	GENERATED_BODY()
+
+public:
+
+    // Makes the controller run its trees on a profiled component, must happen before its first RunBehaviorTree
+    static void InstallOn(AAIController* Controller, const UCharacterDataAsset* DataAsset);
+
+    virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+    UPROPERTY(Transient)
+    TObjectPtr<const UCharacterDataAsset> ProfiledArchetype;
+
+private:
+
+    EAICharacterState GetProfiledState();
+
+    // Resolved again whenever the running blackboard asset changes
+    TWeakObjectPtr<const UBlackboardData> AIStateKeyBlackboard;
+    FBlackboard::FKey AIStateKey = FBlackboard::InvalidKey;
+
+    // World time of the last profiled tick, time since then is spent in the state of the next one
+    double LastProfiledTime = -1.0;
+};
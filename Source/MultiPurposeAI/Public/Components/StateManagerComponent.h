@@ -5,9 +5,19 @@
 #include "CoreMinimal.h"
 #include "Enums.h"
 #include "Components/ActorComponent.h"
+#include "BehaviorTree/BehaviorTreeTypes.h"
 #include "StateManagerComponent.generated.h"
 
+class UAIStateSubsystem;
+class UBlackboardComponent;
+class UCharacterDataAsset;
+class UStateManagerComponent;
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnAIStateChanged, UStateManagerComponent*, StateManager, EAICharacterState, PreviousState, EAICharacterState, NewState);
+
+/**
+ * Handle to the owner's entry in the world's UAIStateSubsystem
+ */
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent), Blueprintable)
 class MULTIPURPOSEAI_API UStateManagerComponent : public UActorComponent
 {
@@ -19,17 +29,60 @@ public:
 
 private:
 
+	// Only used while the component is not registered with a state subsystem
 	EAICharacterState CurrentState;
 
+	// Slot in StateSubsystem, INDEX_NONE while unregistered
+	int32 StateHandle = INDEX_NONE;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UAIStateSubsystem> StateSubsystem;
+
+	// Data asset whose StateTransitions table rules RequestStateChange
+	UPROPERTY(Transient)
+	TObjectPtr<UCharacterDataAsset> TransitionTable;
+
+	// World time each transition rule was last taken, indexed like the table
+	TArray<double> RuleLastUsedTimes;
+
+	double GetWorldTime() const;
+
+	// Index of the rule allowing the change, INDEX_NONE if the table forbids it
+	int32 FindAllowedRule(EAICharacterState FromState, EAICharacterState ToState) const;
+
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
 	
 	UFUNCTION(BlueprintCallable, BlueprintPure)
-	EAICharacterState GetCurrentState() { return CurrentState; }
+	EAICharacterState GetCurrentState() const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	EAICharacterState GetPreviousState() const;
+
+	// Seconds spent in the current state
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	float GetTimeInState() const;
 		
-	UFUNCTION()
+	// Switches state unconditionally, the transition table is not consulted
+	UFUNCTION(BlueprintCallable)
 	void SetCurrentState(EAICharacterState NewState);
+
+	// Switches state only if the transition table allows it (rule, time in state, cooldown and guards)
+	UFUNCTION(BlueprintCallable)
+	bool RequestStateChange(EAICharacterState NewState);
+
+	UFUNCTION(BlueprintCallable)
+	void SetTransitionTable(UCharacterDataAsset* DataAsset);
+
+	// Fired only when the state actually changes
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FOnAIStateChanged OnStateChanged;
+
+	// The state subsystem keeps AIStateKey of this blackboard in sync with the current state
+	void BindBlackboard(UBlackboardComponent* Blackboard, FBlackboard::FKey AIStateKey);
 };
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Enums.h"
+#include "UObject/Object.h"
+#include "AIStateTransition.generated.h"
+
+/**
+ * Extra condition checked before a transition of the table is taken
+ */
+UCLASS(Abstract, Blueprintable, EditInlineNew, DefaultToInstanced, CollapseCategories)
+class MULTIPURPOSEAI_API UAIStateTransitionGuard : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+    // Return false to block the transition
+    UFUNCTION(BlueprintNativeEvent, BlueprintPure, Category = "AI|State")
+    bool CanTransition(AActor* Agent, EAICharacterState FromState, EAICharacterState ToState) const;
+};
+
+/**
+ * One allowed state change of a data asset's transition table
+ */
+USTRUCT(BlueprintType)
+struct FAIStateTransitionRule
+{
+    GENERATED_BODY()
+
+    // State the agent has to be in, None matches any state
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Transition")
+    EAICharacterState FromState = EAICharacterState::None;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Transition")
+    EAICharacterState ToState = EAICharacterState::None;
+
+    // Time the agent has to spend in its current state before this transition is allowed
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Transition", meta = (ClampMin = "0", Units = "s"))
+    float MinTimeInState = 0.0f;
+
+    // Time before the same agent can take this transition again
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Transition", meta = (ClampMin = "0", Units = "s"))
+    float Cooldown = 0.0f;
+
+    // All of them have to pass
+    UPROPERTY(EditAnywhere, Instanced, BlueprintReadOnly, Category = "Transition")
+    TArray<TObjectPtr<UAIStateTransitionGuard>> Guards;
+};
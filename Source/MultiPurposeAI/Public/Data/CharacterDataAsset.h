@@ -5,17 +5,138 @@
 #include "CoreMinimal.h"
 #include "Engine/DataAsset.h" 
 #include "Enums.h"
+#include "Data/AIStateTransition.h"
 #include "Perception/AISense.h"
+#include "BehaviorTree/BehaviorTreeTypes.h"
 #include "CharacterDataAsset.generated.h"
 
 
 
 
 
+class ACharacter;
 class UBehaviorTree;
 class USkeletalMesh;
 class UAnimInstance;
 class UAISenseConfig;
+class UBlackboardData;
+
+/**
+ * Cost settings of one AI LOD tier, applied to every enemy of the archetype within MaxDistance of a player
+ */
+USTRUCT(BlueprintType)
+struct FAILODTier
+{
+    GENERATED_BODY()
+
+    // Enemies closer than this to the nearest player use this tier, the last tier also covers everything beyond
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "LOD", meta = (ClampMin = "0", Units = "cm"))
+    float MaxDistance = 0.0f;
+
+    // Behavior tree, controller and movement tick interval, 0 ticks every frame
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "LOD", meta = (ClampMin = "0", Units = "s"))
+    float LogicTickInterval = 0.0f;
+
+    // Skeletal mesh (animation) tick interval, 0 ticks every frame
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "LOD", meta = (ClampMin = "0", Units = "s"))
+    float AnimationTickInterval = 0.0f;
+
+    // Scales sight and hearing ranges of SensesConfig
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "LOD", meta = (ClampMin = "0", ClampMax = "1"))
+    float SenseRadiusScale = 1.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "LOD")
+    bool bEnablePerception = true;
+
+    // Pauses the behavior tree and stops movement and animation ticking altogether
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "LOD")
+    bool bDormant = false;
+};
+
+/**
+ * Sense configs of one LOD tier, scaled copies of SensesConfig when the tier shrinks the ranges
+ */
+USTRUCT()
+struct FCompiledLODTier
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Transient)
+    TArray<TObjectPtr<UAISenseConfig>> SenseConfigs;
+};
+
+/**
+ * Subtree blackboard entry resolved once per archetype
+ */
+USTRUCT()
+struct FCompiledSubtreeKey
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Transient)
+    EAICharacterState State = EAICharacterState::None;
+
+    // "<State>SubTree", only used when the running blackboard differs from the one the key was resolved against
+    UPROPERTY(Transient)
+    FName KeyName;
+
+    UPROPERTY(Transient)
+    TObjectPtr<UBehaviorTree> Subtree;
+
+    FBlackboard::FKey KeyID = FBlackboard::InvalidKey;
+};
+
+/**
+ * Everything the spawner needs from a data asset, resolved so spawning does no string, FName or asset lookups
+ */
+USTRUCT()
+struct FCompiledCharacterArchetype
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Transient)
+    TObjectPtr<UClass> CharacterClass;
+
+    UPROPERTY(Transient)
+    TObjectPtr<USkeletalMesh> CharacterMesh;
+
+    UPROPERTY(Transient)
+    TObjectPtr<UClass> AnimationBlueprint;
+
+    UPROPERTY(Transient)
+    TObjectPtr<UBehaviorTree> MainBT;
+
+    // Blackboard of MainBT, every key ID below belongs to it
+    UPROPERTY(Transient)
+    TObjectPtr<UBlackboardData> BlackboardAsset;
+
+    // Valid entries of ComponentsToAdd, empty when bEnableComponents is off or the prefab already has them
+    UPROPERTY(Transient)
+    TArray<TSubclassOf<UActorComponent>> ComponentClasses;
+
+    // CharacterClass is the baked prefab
+    bool bUsesPrefab = false;
+
+    UPROPERTY(Transient)
+    TArray<FCompiledSubtreeKey> SubtreeKeys;
+
+    // Valid entries of SensesConfig, one per sense class
+    UPROPERTY(Transient)
+    TArray<TObjectPtr<UAISenseConfig>> SenseConfigs;
+
+    // One entry per LODTiers entry
+    UPROPERTY(Transient)
+    TArray<FCompiledLODTier> LODTiers;
+
+    FBlackboard::FKey AIStateKey = FBlackboard::InvalidKey;
+
+    bool bCompiled = false;
+
+#if WITH_EDITOR
+    // Cache generation the archetype was compiled in, see GetCompiledArchetype
+    uint32 EditorGeneration = 0;
+#endif
+};
 
 /**
  * Data Asset for AI Character Settings
@@ -32,15 +153,23 @@ public:
 
     // This is the Character Class that will be spawned
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character|Spawn")
-    TSubclassOf<ACharacter> CharacterClass;
+    TSoftClassPtr<ACharacter> CharacterClass;
+
+    // Number of dormant characters (and their controllers) created ahead of time for this archetype
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character|Spawn", meta = (ClampMin = "0"))
+    int32 PoolPrewarmCount = 0;
+
+    // Time a dead character stays in the world, stopped, before it goes back to the pool or is destroyed
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character|Spawn", meta = (ClampMin = "0", Units = "s"))
+    float CorpseLifetime = 5.0f;
 
     //The Skeletal Mesh that will be assigned to the Spawned Character Class
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character|Config")
-    USkeletalMesh* CharacterMesh;
+    TSoftObjectPtr<USkeletalMesh> CharacterMesh;
 
     //The Animation Blueprint that will be used to animate the Spawned Character
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character|Config")
-    TSubclassOf<UAnimInstance> AnimationBlueprint;
+    TSoftClassPtr<UAnimInstance> AnimationBlueprint;
 
 public:
     // Boolean to toggle component selection
@@ -55,6 +184,24 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character|Config|Components", meta = (EditCondition = "bEnableComponents"))
     float MaxHealth;
 
+    // Spawn PrefabClass, which already has the components and overrides, instead of adding them at runtime
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character|Prefab")
+    bool bUsePrefab = false;
+
+    // Blueprint generated by BakePrefab from CharacterClass, ComponentsToAdd, MaxHealth and the mesh/anim overrides
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Character|Prefab")
+    TSoftClassPtr<ACharacter> PrefabClass;
+
+    // Set when a baked setting changed since the last bake, spawns then fall back to the runtime path
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Character|Prefab")
+    bool bPrefabOutOfDate = false;
+
+#if WITH_EDITOR
+    // Creates or updates the "<DataAsset>_Prefab" Blueprint next to this asset and saves both
+    UFUNCTION(CallInEditor, Category = "Character|Prefab")
+    void BakePrefab();
+#endif
+
 
     UPROPERTY(EditDefaultsOnly, Instanced, Category = "AI|Perception")
     TArray<TObjectPtr<UAISenseConfig>> SensesConfig;
@@ -62,6 +209,14 @@ public:
     UPROPERTY(EditDefaultsOnly, Category = "AI|Perception")
     TSubclassOf<UAISense> DominantSense;
 
+    // Allies within this distance switch to their DetectionState when this enemy detects something, 0 disables it
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI|Perception", meta = (ClampMin = "0", Units = "cm"))
+    float AlertRadius = 0.0f;
+
+    // Cost tiers by distance to the nearest player, closest first; empty runs every enemy at full cost
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI|LOD")
+    TArray<FAILODTier> LODTiers;
+
     // Subtrees mapping for different behaviors
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI|Behavior")
     EAICharacterState DefaultStartState;
@@ -70,12 +225,37 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI|Behavior")
     EAICharacterState DetectionState;
 
+    // State changes allowed through UStateManagerComponent::RequestStateChange, an empty table allows everything
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI|Behavior|Transitions")
+    TArray<FAIStateTransitionRule> StateTransitions;
+
     // Subtrees mapping for different behaviors
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI|Behavior|MainTree")
-    UBehaviorTree* MainBT;
+    TSoftObjectPtr<UBehaviorTree> MainBT;
 
     // Subtrees mapping for different behaviors
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI|Behavior|SubTrees")
-    TMap<EAICharacterState, UBehaviorTree*> Subtrees;
+    TMap<EAICharacterState, TSoftObjectPtr<UBehaviorTree>> Subtrees;
+
+public:
+    // Name of the blackboard enum key mirroring EAICharacterState
+    static const FName AIStateKeyName;
+
+    // Collects every soft reference the spawner has to stream in before this archetype can be spawned
+    void GetAssetsToPreload(TArray<FSoftObjectPath>& OutAssets) const;
+
+    // Built on first use, loads whatever is not resident yet
+    // In the editor it is built again after PIE starts or a behavior tree or blackboard asset was edited
+    const FCompiledCharacterArchetype& GetCompiledArchetype() const;
+
+#if WITH_EDITOR
+    virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+    void CompileArchetype();
+
+    UPROPERTY(Transient)
+    FCompiledCharacterArchetype CompiledArchetype;
 };
 
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Enums.h"
+#include "UObject/ObjectKey.h"
+
+class UCharacterDataAsset;
+
+/**
+ * Behavior tree cost of every agent of one archetype while it was in one state
+ */
+struct FAIBehaviorTreeProfileEntry
+{
+    // Path name of the data asset, assets with the same name in different folders are kept apart
+    FString Archetype;
+    EAICharacterState State = EAICharacterState::None;
+
+    double TotalMs = 0.0;
+    double MaxMs = 0.0;
+    int64 Ticks = 0;
+
+    // Ticks that processed an execution request and ended on a task, and ticks whose request aborted a running task.
+    // A tick counts once however many tasks it went through, so these are lower bounds on task activations and aborts
+    int64 ExecutionTicks = 0;
+    int64 AbortTicks = 0;
+
+    // Time agents spent in the state, summed over agents, so TotalMs / AgentSeconds is the cost of one agent per second
+    double AgentSeconds = 0.0;
+};
+
+/**
+ * Attributes behavior tree tick time and the ticks that executed or aborted tasks to the archetype and EAICharacterState of the agent.
+ * Fed by UProfiledBehaviorTreeComponent, which the spawner installs on its controllers while MultiPurposeAI.ProfileBehaviorTrees is set.
+ * Dump with MultiPurposeAI.DumpBehaviorTreeProfile [csv], the CSV is also written on exit when anything was recorded.
+ */
+class MULTIPURPOSEAI_API FAIBehaviorTreeProfiler
+{
+public:
+    static bool IsEnabled();
+
+    // Game thread only, like the behavior tree ticks feeding it
+    static void Record(const UCharacterDataAsset* DataAsset, EAICharacterState State, double ElapsedMs, double AgentSeconds, bool bExecutionTick, bool bAbortTick);
+
+    static void Reset();
+
+    static void Dump(FOutputDevice& Ar);
+
+    // Writes Saved/Profiling/MultiPurposeAI/BehaviorTreeProfile-<date>.csv, returns the file name or an empty string
+    static FString WriteCsv();
+
+private:
+    // Most expensive first
+    static void GetSortedEntries(TArray<const FAIBehaviorTreeProfileEntry*>& OutEntries);
+
+    static void HandleEnginePreExit();
+
+    // Keyed by the data asset itself, its path is only built when the entry is added
+    static TMap<TPair<FObjectKey, EAICharacterState>, FAIBehaviorTreeProfileEntry> Entries;
+
+    static bool bExitHandlerRegistered;
+};
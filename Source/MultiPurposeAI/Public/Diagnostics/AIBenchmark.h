@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+class UCharacterDataAsset;
+
+/**
+ * Timings of one benchmark phase, one sample per enemy
+ */
+struct FAIBenchmarkPhase
+{
+    FString Name;
+    TArray<double> SamplesMs;
+    int64 MemoryDeltaBytes = 0;
+
+    // Size of what the phase produced, e.g. a snapshot blob
+    int64 PayloadBytes = 0;
+
+    double GetTotalMs() const;
+    double GetPercentileMs(float Percentile) const;
+};
+
+/**
+ * Every phase of one enemy count with one perception setup
+ */
+struct FAIBenchmarkRun
+{
+    int32 EnemyCount = 0;
+    bool bBatchPerceptionSetup = true;
+
+    // Adds a stock sight and a batched sight perception frame phase with the same radii and cone
+    bool bCompareSight = false;
+
+    TArray<FAIBenchmarkPhase> Phases;
+
+    // Outcome of the run, checked by the automation tests
+    int32 NumSpawned = 0;
+    int32 NumRestored = 0;
+
+    // Enemies with a damageable component still alive once the lethal hits were resolved
+    int32 NumSurvivedLethalDamage = 0;
+};
+
+/**
+ * Spawns N enemies of an archetype in the current world and times spawn, initialization, perception dispatch, snapshot save/restore and damage/death
+ * Run it headless with: -game -nullrhi -ExecCmds="MultiPurposeAI.Benchmark /Game/Path/DataAsset 100 1000 5000, quit"
+ * Add "compareperception" to run every count with both the batched and the per-agent perception setup
+ * Add "comparesight" to time perception frames with every enemy on the stock sight, then on UAISense_BatchedSight
+ * The MultiPurposeAI.Benchmark automation tests run the same phases against pass/fail budgets
+ */
+class MULTIPURPOSEAI_API FAIBenchmark
+{
+public:
+    // Results are written to Saved/Profiling/MultiPurposeAI as CSV and JSON, returns false if nothing could be run
+    static bool Run(UWorld* World, UCharacterDataAsset* DataAsset, const TArray<int32>& EnemyCounts, bool bComparePerceptionSetup, bool bCompareSight, FOutputDevice& Ar);
+
+    // Every phase for Run.EnemyCount enemies with Run's settings, also used by the MultiPurposeAI.Benchmark automation tests
+    static void RunOnce(UWorld* World, UCharacterDataAsset* DataAsset, FAIBenchmarkRun& Run);
+
+    static void WriteResults(const UCharacterDataAsset* DataAsset, const TArray<FAIBenchmarkRun>& Results, FOutputDevice& Ar);
+};
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+// Counters are compiled out of shipping builds unless the target defines MPAI_WITH_DIAGNOSTICS=1
+#ifndef MPAI_WITH_DIAGNOSTICS
+#define MPAI_WITH_DIAGNOSTICS !UE_BUILD_SHIPPING
+#endif
+
+/**
+ * Events counted instead of logged on the spawn, perception and combat paths
+ */
+enum class EAIDiagnosticCounter : uint8
+{
+    EnemiesCreated,
+    EnemiesAcquiredFromPool,
+    EnemiesReleased,
+    ComponentsAdded,
+    SensesConfigured,
+    PerceptionEvents,
+    Detections,
+    DamageEvents,
+    Deaths,
+    SubtreesRun,
+    SubtreesInjected,
+    StreamingCellsActivated,
+    StreamingCellsDeactivated,
+    SpawnPointsSnapped,
+    SpawnPointsRejected,
+    BlackboardWritesApplied,
+    BlackboardWritesSuppressed,
+    SightTracesStarted,
+    SightCacheHits,
+
+    Num
+};
+
+/**
+ * Lock-free event counters, dumped with MultiPurposeAI.DumpCounters
+ */
+class MULTIPURPOSEAI_API FAIDiagnostics
+{
+public:
+    static void Increment(EAIDiagnosticCounter Counter, int64 Amount = 1)
+    {
+        Counters[static_cast<uint8>(Counter)].fetch_add(Amount, std::memory_order_relaxed);
+    }
+
+    static int64 Get(EAIDiagnosticCounter Counter)
+    {
+        return Counters[static_cast<uint8>(Counter)].load(std::memory_order_relaxed);
+    }
+
+    static const TCHAR* GetCounterName(EAIDiagnosticCounter Counter);
+
+    static void Reset();
+
+    static void Dump(FOutputDevice& Ar);
+
+private:
+    static std::atomic<int64> Counters[static_cast<uint8>(EAIDiagnosticCounter::Num)];
+};
+
+#if MPAI_WITH_DIAGNOSTICS
+#define MPAI_COUNT(Counter) FAIDiagnostics::Increment(EAIDiagnosticCounter::Counter)
+#define MPAI_COUNT_N(Counter, Amount) FAIDiagnostics::Increment(EAIDiagnosticCounter::Counter, Amount)
+#else
+#define MPAI_COUNT(Counter)
+#define MPAI_COUNT_N(Counter, Amount)
+#endif
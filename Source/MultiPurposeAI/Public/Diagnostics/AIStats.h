@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+// Everything below shows up with "stat MultiPurposeAI"
+DECLARE_STATS_GROUP(TEXT("MultiPurposeAI"), STATGROUP_MultiPurposeAI, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn Enemy"), STAT_MPAI_SpawnEnemy, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Initialize Enemy"), STAT_MPAI_InitializeEnemy, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Add Components"), STAT_MPAI_AddComponents, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Assign Perception Config"), STAT_MPAI_AssignPerceptionConfig, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Perception Updated"), STAT_MPAI_PerceptionUpdated, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Run Behavior Tree From BB"), STAT_MPAI_RunBehaviorTreeFromBB, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Take Damage"), STAT_MPAI_TakeDamage, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Process Damage Queue"), STAT_MPAI_ProcessDamage, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("LOD Pass"), STAT_MPAI_LODPass, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Streaming Update"), STAT_MPAI_StreamingUpdate, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Save Snapshot"), STAT_MPAI_SaveSnapshot, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Restore Snapshot"), STAT_MPAI_RestoreSnapshot, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Crowd Update"), STAT_MPAI_CrowdUpdate, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Validate Spawn Points"), STAT_MPAI_ValidateSpawnPoints, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Blackboard Flush"), STAT_MPAI_BlackboardFlush, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Batched Sight Update"), STAT_MPAI_BatchedSightUpdate, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live Agents"), STAT_MPAI_LiveAgents, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pooled Agents"), STAT_MPAI_PooledAgents, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Crowd Entities"), STAT_MPAI_CrowdEntities, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Crowd Promoted"), STAT_MPAI_CrowdPromoted, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+
+// Reset every frame, so it reads as state changes per frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("State Changes"), STAT_MPAI_StateChanges, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Blackboard Writes Suppressed"), STAT_MPAI_BlackboardWritesSuppressed, STATGROUP_MultiPurposeAI, MULTIPURPOSEAI_API);
+
+// Enable with -trace=cpu,MultiPurposeAI to get the module's scopes in Insights without the rest of the stats overhead
+UE_TRACE_CHANNEL_EXTERN(MultiPurposeAIChannel, MULTIPURPOSEAI_API);
+
+// Cycle counter for "stat MultiPurposeAI" plus a CPU scope on the MultiPurposeAI trace channel
+#define MPAI_SCOPE_CYCLE_COUNTER(Stat) \
+    SCOPE_CYCLE_COUNTER(Stat); \
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, MultiPurposeAIChannel)
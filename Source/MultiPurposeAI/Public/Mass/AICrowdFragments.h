@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "Enums.h"
+#include "AICrowdFragments.generated.h"
+
+class ACharacter;
+class AEnemySpawner;
+class UCharacterDataAsset;
+
+/**
+ * Where a crowd enemy is, copied from its character while it is promoted
+ */
+USTRUCT()
+struct MULTIPURPOSEAI_API FAICrowdTransformFragment : public FMassFragment
+{
+    GENERATED_BODY()
+
+    FTransform Transform;
+};
+
+/**
+ * Health of a crowd enemy, taken from its character when it is demoted and handed back when it is promoted
+ * Entities only take damage through their character, one that comes back at 0 is removed
+ */
+USTRUCT()
+struct MULTIPURPOSEAI_API FAICrowdHealthFragment : public FMassFragment
+{
+    GENERATED_BODY()
+
+    float CurrentHealth = 0.0f;
+    float MaxHealth = 0.0f;
+};
+
+/**
+ * Full character standing in for the entity while it is significant
+ */
+USTRUCT()
+struct MULTIPURPOSEAI_API FAICrowdRepresentationFragment : public FMassFragment
+{
+    GENERATED_BODY()
+
+    // Only touched on the game thread, processors read bHasActor
+    TWeakObjectPtr<ACharacter> Actor;
+
+    int32 SquadId = INDEX_NONE;
+
+    // State the character had when it was demoted, the character starts in it again on promotion
+    EAICharacterState State = EAICharacterState::None;
+
+    bool bHasActor = false;
+};
+
+/**
+ * Archetype of the entity and the spawner that promotes it, shared by every entity spawned from the same pair
+ */
+USTRUCT()
+struct MULTIPURPOSEAI_API FAICrowdArchetypeFragment : public FMassSharedFragment
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Transient)
+    TObjectPtr<UCharacterDataAsset> DataAsset;
+
+    UPROPERTY(Transient)
+    TObjectPtr<AEnemySpawner> Spawner;
+};
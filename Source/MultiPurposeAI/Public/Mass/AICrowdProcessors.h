@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassProcessor.h"
+#include "MassEntityQuery.h"
+#include "AICrowdProcessors.generated.h"
+
+/**
+ * Sorts crowd enemies into the ones to promote to a character, to demote back and to remove, chunks are processed in parallel
+ * Run by UAICrowdSubsystem, not by the Mass processing phases
+ */
+UCLASS()
+class MULTIPURPOSEAI_API UAICrowdSignificanceProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+    UAICrowdSignificanceProcessor();
+
+    // Inputs, set before every run
+    TArray<FVector> SourceLocations;
+    float PromoteRadius = 0.0f;
+    float DemoteRadius = 0.0f;
+
+    // Outputs, reset at the start of every run
+    TArray<FMassEntityHandle> EntitiesToPromote;
+    TArray<FMassEntityHandle> EntitiesToDemote;
+    TArray<FMassEntityHandle> DeadEntities;
+
+protected:
+    virtual void ConfigureQueries() override;
+    virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+    FMassEntityQuery EntityQuery;
+
+    // Guards the outputs while chunks append to them
+    FCriticalSection OutputLock;
+};
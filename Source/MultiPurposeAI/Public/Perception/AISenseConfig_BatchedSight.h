@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Perception/AISenseConfig.h"
+#include "Perception/AIPerceptionTypes.h"
+#include "Perception/AISense_BatchedSight.h"
+#include "AISenseConfig_BatchedSight.generated.h"
+
+/**
+ * Sight settings of one listener for UAISense_BatchedSight, assignable in UCharacterDataAsset::SensesConfig
+ * in place of the stock sight config. Trace budget and result caching are shared by every listener, see the sense.
+ */
+UCLASS(meta = (DisplayName = "AI Batched Sight config"))
+class MULTIPURPOSEAI_API UAISenseConfig_BatchedSight : public UAISenseConfig
+{
+	GENERATED_BODY()
+
+public:
+
+    UAISenseConfig_BatchedSight(const FObjectInitializer& ObjectInitializer);
+
+    virtual TSubclassOf<UAISense> GetSenseImplementation() const override;
+
+    UPROPERTY(EditDefaultsOnly, Category = "Sense", NoClear, config)
+    TSubclassOf<UAISense_BatchedSight> Implementation;
+
+    // Targets closer than this start being seen
+    UPROPERTY(EditAnywhere, Category = "Sense", config, meta = (ClampMin = "0", Units = "cm"))
+    float SightRadius = 3000.0f;
+
+    // Seen targets are lost beyond this, keep it above SightRadius to avoid flickering at the edge
+    UPROPERTY(EditAnywhere, Category = "Sense", config, meta = (ClampMin = "0", Units = "cm"))
+    float LoseSightRadius = 3500.0f;
+
+    // Half angle of the vision cone around the listener's view direction
+    UPROPERTY(EditAnywhere, Category = "Sense", config, meta = (ClampMin = "0", ClampMax = "180", Units = "deg"))
+    float PeripheralVisionAngleDegrees = 90.0f;
+
+    UPROPERTY(EditAnywhere, Category = "Sense", config)
+    FAISenseAffiliationFilter DetectionByAffiliation;
+};
@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Perception/AISense.h"
+#include "Engine/EngineTypes.h"
+#include "WorldCollision.h"
+#include "AISense_BatchedSight.generated.h"
+
+class UAISenseConfig_BatchedSight;
+
+/**
+ * Sight for large agent counts, configured with UAISenseConfig_BatchedSight.
+ * Every update tests all listener/target pairs for range and cone in one pass over structure-of-arrays positions,
+ * four targets at a time. Line of sight is only traced for the pairs that pass, with async traces capped per update,
+ * and a pair's result is reused for VisibilityCacheTime before it is traced again.
+ */
+UCLASS(ClassGroup = AI, config = Game)
+class MULTIPURPOSEAI_API UAISense_BatchedSight : public UAISense
+{
+	GENERATED_BODY()
+
+public:
+
+    UAISense_BatchedSight(const FObjectInitializer& ObjectInitializer);
+
+    virtual void RegisterSource(AActor& SourceActor) override;
+    virtual void UnregisterSource(AActor& SourceActor) override;
+
+protected:
+
+    virtual float Update() override;
+
+    void OnNewListenerImpl(const FPerceptionListener& NewListener);
+    void OnListenerUpdateImpl(const FPerceptionListener& UpdatedListener);
+    void OnListenerRemovedImpl(const FPerceptionListener& RemovedListener);
+
+    // Line of sight traces started per update, the remaining candidate pairs keep their last result
+    UPROPERTY(Config)
+    int32 MaxTracesPerUpdate = 128;
+
+    // Seconds a pair's line of sight result is reused before it is traced again
+    UPROPERTY(Config)
+    float VisibilityCacheTime = 0.25f;
+
+    UPROPERTY(Config)
+    TEnumAsByte<ECollisionChannel> SightTraceChannel = ECC_Visibility;
+
+private:
+
+    // Listener settings digested from its config
+    struct FDigestedSightProperties
+    {
+        float SightRadiusSq = 0.0f;
+        float LoseSightRadiusSq = 0.0f;
+        float PeripheralVisionCos = 0.0f;
+        uint8 AffiliationFlags = 0;
+    };
+
+    // Line of sight between one listener and one target
+    struct FSightPair
+    {
+        FPerceptionListenerID ListenerId;
+        int32 TargetIndex = INDEX_NONE;
+
+        // Result of the last completed trace
+        bool bVisible = false;
+
+        // Last state reported to the listener as a stimulus
+        bool bReportedVisible = false;
+
+        // A trace completed since the last update, a visible target is reported again at its current location
+        bool bNewResult = false;
+
+        double TraceTime = -1.0;
+        FTraceHandle PendingTrace;
+
+        // Update counter of the last update the pair passed range and cone in
+        uint32 LastCandidateUpdate = 0;
+    };
+
+    // Listener and target slot
+    using FSightPairKey = TPair<FPerceptionListenerID, int32>;
+
+    // Copies the target positions into TargetX/Y/Z, padded to a multiple of four
+    void GatherTargets();
+
+    // Collects the traces started by earlier updates
+    void CollectTraceResults(UWorld& World);
+
+    // Range and cone test of every target against one listener, adds the passing pairs to CandidatePairs
+    void GatherCandidates(const FPerceptionListenerID& ListenerId, const FPerceptionListener& Listener, const FDigestedSightProperties& Properties);
+
+    void StartTrace(UWorld& World, const FPerceptionListener& Listener, const AActor& Target, FSightPair& Pair);
+
+    void ReportStimulus(FPerceptionListener& Listener, AActor& Target, bool bVisible);
+
+    void DigestListener(const FPerceptionListener& Listener);
+
+    TMap<FPerceptionListenerID, FDigestedSightProperties> DigestedProperties;
+
+    // Registered sources, slots are reused through FreeTargetSlots
+    TArray<TWeakObjectPtr<AActor>> Targets;
+    TMap<TWeakObjectPtr<AActor>, int32> TargetIndices;
+    TArray<int32> FreeTargetSlots;
+
+    // Unregistered this update, only reused once their pairs are gone
+    TArray<int32> ReleasedTargetSlots;
+
+    // Target positions of the current update, one float per lane, unused and padding lanes are out of every range
+    TArray<float> TargetX;
+    TArray<float> TargetY;
+    TArray<float> TargetZ;
+
+    TMap<FSightPairKey, FSightPair> Pairs;
+
+    // Scratch of Update, keys of the pairs that passed range and cone this update
+    TArray<FSightPairKey> CandidatePairs;
+
+    uint32 UpdateCounter = 0;
+
+    // First candidate allowed to trace next update, so a capped budget goes round every pair
+    int32 TraceCursor = 0;
+};
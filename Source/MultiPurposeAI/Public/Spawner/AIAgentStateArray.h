@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "AIAgentStateArray.generated.h"
+
+class ACharacter;
+class AAIAgentStateReplicator;
+struct FAIAgentStateArray;
+
+/**
+ * Replicated view of one live enemy: its state and its health quantized to a byte
+ */
+USTRUCT()
+struct FAIAgentStateItem : public FFastArraySerializerItem
+{
+    GENERATED_BODY()
+
+    // Resolves to null on clients the enemy is not relevant to
+    UPROPERTY()
+    TObjectPtr<ACharacter> Agent;
+
+    // EAICharacterState
+    UPROPERTY()
+    uint8 State = 0;
+
+    // Current health over max health in 1/255 steps
+    UPROPERTY()
+    uint8 QuantizedHealth = 0;
+
+    float GetHealthFraction() const { return QuantizedHealth / 255.0f; }
+
+    void PostReplicatedAdd(const FAIAgentStateArray& InArray);
+    void PostReplicatedChange(const FAIAgentStateArray& InArray);
+    void PreReplicatedRemove(const FAIAgentStateArray& InArray);
+};
+
+/**
+ * Live enemies of a spawner, only the items whose state or quantized health changed are sent
+ * The server keeps every live enemy in the spawner's array, each player's AAIAgentStateReplicator the ones relevant to it
+ */
+USTRUCT()
+struct FAIAgentStateArray : public FFastArraySerializer
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    TArray<FAIAgentStateItem> Items;
+
+    // Notified on clients when an item arrives, changes or goes away
+    UPROPERTY(NotReplicated)
+    TObjectPtr<AAIAgentStateReplicator> OwnerReplicator;
+
+    static uint8 QuantizeHealth(float CurrentHealth, float MaxHealth);
+
+    // Server side, adds the agent or marks it dirty if either value changed
+    void SetAgent(ACharacter* Agent, uint8 State, uint8 QuantizedHealth);
+
+    // Server side
+    void RemoveAgent(const ACharacter* Agent);
+
+    // Server side, drops the items of agents destroyed without going through RemoveAgent, e.g. by gameplay or kill Z
+    void RemoveInvalidAgents();
+
+    // Either side, null for agents that are not in the array or not resolved yet
+    const FAIAgentStateItem* FindAgent(const ACharacter* Agent) const;
+
+    bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+    {
+        return FFastArraySerializer::FastArrayDeltaSerialize<FAIAgentStateItem, FAIAgentStateArray>(Items, DeltaParms, *this);
+    }
+
+private:
+    friend struct FAIAgentStateItem;
+
+    void RemoveItemAt(int32 Index);
+
+    // Rebuilt lazily, replicated adds and removals reorder Items on clients
+    mutable TMap<TWeakObjectPtr<const ACharacter>, int32> ItemIndices;
+    mutable bool bItemIndicesDirty = true;
+};
+
+template<>
+struct TStructOpsTypeTraits<FAIAgentStateArray> : public TStructOpsTypeTraitsBase2<FAIAgentStateArray>
+{
+    enum
+    {
+        WithNetDeltaSerializer = true,
+    };
+};
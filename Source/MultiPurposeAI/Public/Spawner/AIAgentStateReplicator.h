@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "Spawner/AIAgentStateArray.h"
+#include "AIAgentStateReplicator.generated.h"
+
+class AEnemySpawner;
+
+/**
+ * Carries the agent states of one spawner to one remote player, owned by that player's controller and only relevant to it
+ * Holds the items of the enemies that are net relevant to the player, so nobody receives enemies they cannot see
+ */
+UCLASS(NotPlaceable, Transient)
+class MULTIPURPOSEAI_API AAIAgentStateReplicator : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+
+    AAIAgentStateReplicator();
+
+    virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+    // Server side, right after spawning it with the player controller as owner
+    void Initialize(AEnemySpawner* InSpawner);
+
+    // Server side, copies the items of ServerStates relevant to the owning player and drops the ones that stopped being relevant
+    void UpdateAgentStates(const FAIAgentStateArray& ServerStates);
+
+    // Server side
+    void RemoveAgent(const ACharacter* Agent);
+
+    AEnemySpawner* GetSpawner() const { return Spawner; }
+
+    const FAIAgentStateArray& GetAgentStates() const { return AgentStates; }
+
+    // AgentStates callbacks on the owning client, forwarded to the spawner's delegates
+    void HandleAgentStateReplicated(const FAIAgentStateItem& Item);
+    void HandleAgentStateRemoved(const FAIAgentStateItem& Item);
+
+private:
+
+    UFUNCTION()
+    void OnRep_Spawner();
+
+    // Replicated before AgentStates, so the first items already know where to go
+    UPROPERTY(ReplicatedUsing = OnRep_Spawner)
+    TObjectPtr<AEnemySpawner> Spawner;
+
+    UPROPERTY(Replicated)
+    FAIAgentStateArray AgentStates;
+
+    // Items arrived before Spawner resolved, OnRep_Spawner announces them
+    bool bMissedAgentStates = false;
+};
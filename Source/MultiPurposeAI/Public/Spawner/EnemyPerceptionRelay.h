@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Perception/AIPerceptionTypes.h"
+#include "EnemyPerceptionRelay.generated.h"
+
+class ACharacter;
+class AEnemySpawner;
+
+/**
+ * Bound on a single enemy's perception component so the spawner knows which enemy perceived the stimulus
+ */
+UCLASS()
+class MULTIPURPOSEAI_API UEnemyPerceptionRelay : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+    void Initialize(AEnemySpawner* InSpawner, ACharacter* InEnemy);
+
+    UFUNCTION()
+    void OnTargetPerceptionUpdated(AActor* Actor, FAIStimulus Stimulus);
+
+private:
+
+    TWeakObjectPtr<AEnemySpawner> Spawner;
+
+    TWeakObjectPtr<ACharacter> Enemy;
+};
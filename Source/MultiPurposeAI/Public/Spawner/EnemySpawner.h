@@ -5,6 +5,10 @@
 #include "CoreMinimal.h"
 #include "Enums.h"
 #include "UObject/NoExportTypes.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/EngineTypes.h"
+#include "BehaviorTree/BehaviorTreeTypes.h"
+#include "Spawner/AIAgentStateArray.h"
 #include "EnemySpawner.generated.h"
 
 
@@ -15,6 +19,29 @@ class UBehaviorTree;
 class USkeletalMesh;
 class UAnimInstance;
 class UCharacterDataAsset;
+class UBlackboardComponent;
+class UStateManagerComponent;
+class UDamageableComponent;
+class UEnemyPerceptionRelay;
+class UAlertPropagationSubsystem;
+class UDamageQueueSubsystem;
+class UAIPerceptionComponent;
+class UAISense;
+class UAILODSubsystem;
+class UAICrowdSubsystem;
+class UBlackboardWriteSubsystem;
+class AAIAgentStateReplicator;
+struct FAIStimulus;
+struct FEnemySpawnerSnapshot;
+struct FTraceHandle;
+struct FTraceDatum;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnSpawnQueueProgress, int32, ProcessedCount, int32, TotalCount);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnSpawnQueueCompleted);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnArchetypeLoaded, UCharacterDataAsset*, CharacterDataAsset, float, LoadLatencyMs);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnAgentStateReplicated, ACharacter*, Agent, EAICharacterState, State, float, HealthFraction);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAgentStateRemoved, ACharacter*, Agent);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnSnapshotRestored);
 
 /**
  * 
@@ -32,6 +59,10 @@ struct FEnemySpawnData
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Transform")
     FTransform SpawnTransform;
 
+    // Enemies sharing a squad are all alerted when one of them detects something, -1 for no squad
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Enemy Data")
+    int32 SquadId = INDEX_NONE;
+
     //Visual Debug
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug")
     float DebugSphereRadius;
@@ -56,6 +87,163 @@ struct FEnemySpawnData
 
 };
 
+/**
+ * Dormant characters of a single archetype, kept hidden with collision and tick disabled
+ */
+USTRUCT()
+struct FEnemyPool
+{
+    GENERATED_BODY()
+
+    // Characters ready to be reused, each one still possessed by its AI controller
+    UPROPERTY(Transient)
+    TArray<TObjectPtr<ACharacter>> DormantEnemies;
+};
+
+/**
+ * Dead enemy left in the world until its corpse lifetime runs out
+ */
+USTRUCT()
+struct FEnemyCorpse
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Transient)
+    TObjectPtr<ACharacter> Enemy;
+
+    // World time at which the corpse is recycled
+    double RecycleTime = 0.0;
+
+    // Heap order, the corpse to recycle first on top
+    bool operator<(const FEnemyCorpse& Other) const
+    {
+        return RecycleTime < Other.RecycleTime;
+    }
+};
+
+/**
+ * Everything the spawner touches on a spawned enemy, cached once so the hot paths don't search components
+ */
+USTRUCT()
+struct FSpawnedEnemyRecord
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Transient)
+    TObjectPtr<UCharacterDataAsset> DataAsset;
+
+    UPROPERTY(Transient)
+    TObjectPtr<AAIController> Controller;
+
+    UPROPERTY(Transient)
+    TObjectPtr<UBlackboardComponent> Blackboard;
+
+    UPROPERTY(Transient)
+    TObjectPtr<UStateManagerComponent> StateManager;
+
+    UPROPERTY(Transient)
+    TObjectPtr<UDamageableComponent> DamageComponent;
+
+    // Forwards this enemy's perception events to the spawner
+    UPROPERTY(Transient)
+    TObjectPtr<UEnemyPerceptionRelay> PerceptionRelay;
+
+    // AIState key of Blackboard
+    FBlackboard::FKey AIStateKey = FBlackboard::InvalidKey;
+
+    int32 SquadId = INDEX_NONE;
+
+    // EnemiesToSpawn entry this enemy streams in for, INDEX_NONE when it is not streamed
+    int32 StreamingEntry = INDEX_NONE;
+
+    // The component pointers above were filled by CacheEnemyRecord
+    bool bComponentsCached = false;
+};
+
+/**
+ * Entry of the time-sliced spawn queue
+ */
+USTRUCT()
+struct FPendingEnemySpawn
+{
+    GENERATED_BODY()
+
+    UPROPERTY(Transient)
+    FEnemySpawnData SpawnData;
+
+    // Lower values are spawned first (queue order or squared distance to the closest player)
+    float Priority = 0.0f;
+
+    // Only adds a dormant character to the archetype pool
+    bool bPrewarmOnly = false;
+
+    // EnemiesToSpawn entry of a streaming cell, dropped if the cell is gone again when its turn comes
+    int32 StreamingEntry = INDEX_NONE;
+};
+
+/**
+ * Grid cell of EnemiesToSpawn entries that are spawned and despawned together when proximity streaming is on
+ */
+USTRUCT()
+struct FEnemyStreamingCell
+{
+    GENERATED_BODY()
+
+    // Area covered by the cell, sources are measured against it on the XY plane
+    FBox2D Bounds = FBox2D(ForceInit);
+
+    // Indices into EnemiesToSpawn
+    TArray<int32> Entries;
+
+    bool bActive = false;
+};
+
+/**
+ * Streaming state of one EnemiesToSpawn entry, so it comes back the way it left
+ */
+USTRUCT()
+struct FStreamedEnemyState
+{
+    GENERATED_BODY()
+
+    // Live character of the entry, null while its cell is out of range
+    UPROPERTY(Transient)
+    TObjectPtr<ACharacter> Enemy;
+
+    int32 Cell = INDEX_NONE;
+
+    // Health when last despawned, negative until then
+    float SavedHealth = -1.0f;
+
+    EAICharacterState SavedState = EAICharacterState::None;
+
+    // Waiting in the spawn queue
+    bool bQueued = false;
+
+    // Killed, never streamed in again
+    bool bDead = false;
+};
+
+/**
+ * Streaming state of the assets referenced by one data asset
+ */
+USTRUCT()
+struct FArchetypePreload
+{
+    GENERATED_BODY()
+
+    // Spawns held back until the archetype is resident
+    UPROPERTY(Transient)
+    TArray<FPendingEnemySpawn> WaitingSpawns;
+
+    // Keeps the streamed assets resident for as long as the spawner lives
+    TSharedPtr<FStreamableHandle> Handle;
+
+    double RequestTime = 0.0;
+    float LoadLatencyMs = -1.0f;
+    bool bLoaded = false;
+};
+
 
 UCLASS(Blueprintable)
 class MULTIPURPOSEAI_API AEnemySpawner : public AActor
@@ -70,12 +258,189 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Spawner")
     ACharacter* SpawnEnemy(const FEnemySpawnData& EnemyData);
 
+    // Spawns a crowd entity as a character that starts with the entity's health and state, null if it could not be spawned
+    ACharacter* PromoteCrowdEnemy(const FEnemySpawnData& EnemyData, float Health, EAICharacterState State);
+
+    // Takes a promoted crowd enemy out of the world and returns the health (negative without a damageable component) and
+    // state its entity keeps, false if it is not a live enemy of this spawner
+    bool DemoteCrowdEnemy(ACharacter* Enemy, float& OutHealth, EAICharacterState& OutState);
+
+    // Takes a dormant character out of the archetype pool (or creates one) and activates it at the given transform
+    UFUNCTION(BlueprintCallable, Category = "Spawner|Pool")
+    ACharacter* AcquireEnemy(UCharacterDataAsset* CharacterDataAsset, const FTransform& SpawnTransform, int32 SquadId = -1);
+
+    // Deactivates a character previously returned by this spawner and puts it back in its archetype pool
+    UFUNCTION(BlueprintCallable, Category = "Spawner|Pool")
+    void ReleaseEnemy(ACharacter* Enemy);
+
+    // Creates dormant characters until the archetype pool holds at least Count of them
+    UFUNCTION(BlueprintCallable, Category = "Spawner|Pool")
+    void PrewarmPool(UCharacterDataAsset* CharacterDataAsset, int32 Count);
+
+    // Adds an enemy to the spawn queue, it will be spawned within the per-frame budget
+    UFUNCTION(BlueprintCallable, Category = "Spawner|Queue")
+    void QueueEnemySpawn(const FEnemySpawnData& EnemyData);
+
+    // Queues Count dormant characters for the archetype pool, processed after every pending spawn
+    UFUNCTION(BlueprintCallable, Category = "Spawner|Queue")
+    void QueuePoolPrewarm(UCharacterDataAsset* CharacterDataAsset, int32 Count);
+
+    // Spawns everything left in the queue right now, ignoring the budget
+    UFUNCTION(BlueprintCallable, Category = "Spawner|Queue")
+    void FlushSpawnQueue();
+
+    // Starts streaming every asset the archetype references, spawns of it are held back until they are resident
+    UFUNCTION(BlueprintCallable, Category = "Spawner|Preload")
+    void PreloadArchetype(UCharacterDataAsset* CharacterDataAsset);
+
+    UFUNCTION(BlueprintPure, Category = "Spawner|Preload")
+    bool IsArchetypeResident(const UCharacterDataAsset* CharacterDataAsset) const;
+
+    // Time between the preload request and the archetype being resident, negative while it is still loading
+    UFUNCTION(BlueprintPure, Category = "Spawner|Preload")
+    float GetArchetypeLoadLatencyMs(const UCharacterDataAsset* CharacterDataAsset) const;
+
+    // Spawns the streaming cells a source came close to and despawns the ones every source left, runs on a timer while streaming is on
+    UFUNCTION(BlueprintCallable, Category = "Spawner|Streaming")
+    void UpdateStreaming();
+
+    // Writes every live enemy (transform, health, state, squad, streaming entry) to a versioned binary FEnemySpawnerSnapshot
+    UFUNCTION(BlueprintCallable, Category = "Spawner|Snapshot")
+    void SaveSnapshot(TArray<uint8>& OutData) const;
+
+    // Replaces the live and queued enemies with the ones of a snapshot once its archetypes are preloaded, right away when
+    // they already are; false if the data is not a readable snapshot
+    UFUNCTION(BlueprintCallable, Category = "Spawner|Snapshot")
+    bool RestoreSnapshot(const TArray<uint8>& Data);
+
+    // Last replicated state and health (0 to 1) of a live enemy, on clients as well as on the server; false if it is not known
+    UFUNCTION(BlueprintPure, Category = "Spawner|Replication")
+    bool GetReplicatedAgentState(const ACharacter* Agent, EAICharacterState& OutState, float& OutHealthFraction) const;
+
+    // 0 to 1 progress of the current queue, 1 when nothing is pending
+    UFUNCTION(BlueprintPure, Category = "Spawner|Queue")
+    float GetSpawnQueueProgress() const;
+
+    virtual void Tick(float DeltaSeconds) override;
+
+    // Called on clients by the agent state replicator of the local player once it knows its spawner
+    void SetLocalAgentStateReplicator(AAIAgentStateReplicator* Replicator);
+
 
 public:
 
     UPROPERTY(EditAnywhere,BlueprintReadOnly, Category= "Spawn|Enemies")
     TArray<FEnemySpawnData> EnemiesToSpawn;
 
+    // Reuse dead enemies instead of spawning and destroying actors
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Pool")
+    bool bUsePooling = true;
+
+    // Spread the BeginPlay spawns over several frames instead of spawning everything at once
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Queue")
+    bool bTimeSliceSpawning = true;
+
+    // Time the spawn queue may use per frame, at least one entry is processed every frame
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Queue", meta = (EditCondition = "bTimeSliceSpawning", ClampMin = "0.1", Units = "ms"))
+    float SpawnBudgetMs = 2.0f;
+
+    // Spawn the enemies closest to a player first
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Queue")
+    bool bPrioritizeByPlayerDistance = true;
+
+    // Distance priorities are only refreshed once a player moved this far from where they were last scored
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Queue", meta = (EditCondition = "bPrioritizeByPlayerDistance", ClampMin = "0", Units = "cm"))
+    float SpawnQueueRescoreDistance = 500.0f;
+
+    // Resolve hits on this spawner's enemies once per frame through UDamageQueueSubsystem, their health and death lag behind ApplyDamage until then
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Death")
+    bool bUseDamageQueue = true;
+
+    // Corpses recycled (pooled or destroyed) per frame at most, the rest wait for the next frames
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Death", meta = (ClampMin = "1"))
+    int32 MaxCorpseRecyclesPerFrame = 4;
+
+    // Configure perception before registering it and add the listeners once per spawn batch; pooled enemies keep their senses
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Perception")
+    bool bBatchPerceptionSetup = true;
+
+    // Spawn EnemiesToSpawn one grid cell at a time when a player or world partition streaming source comes close, despawn them when all leave
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Streaming")
+    bool bUseProximityStreaming = false;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Streaming", meta = (EditCondition = "bUseProximityStreaming", ClampMin = "100", Units = "cm"))
+    float StreamingCellSize = 5000.0f;
+
+    // A cell spawns its enemies once a source is this close to it
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Streaming", meta = (EditCondition = "bUseProximityStreaming", ClampMin = "0", Units = "cm"))
+    float ActivationRadius = 8000.0f;
+
+    // A cell despawns its enemies once every source is further than this, the gap to ActivationRadius keeps cells on the edge from thrashing
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Streaming", meta = (EditCondition = "bUseProximityStreaming", ClampMin = "0", Units = "cm"))
+    float DeactivationRadius = 10000.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Streaming", meta = (EditCondition = "bUseProximityStreaming", ClampMin = "0.05", Units = "s"))
+    float StreamingUpdateInterval = 0.5f;
+
+    // Keep EnemiesToSpawn as lightweight Mass entities and only spawn characters for the ones near a player, see UAICrowdSubsystem
+    // Takes over from proximity streaming for these entries
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Crowd")
+    bool bSpawnAsCrowd = false;
+
+    // Replicate the state and quantized health of every live enemy to clients, e.g. for health bars
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Replication")
+    bool bReplicateAgentStates = true;
+
+    // Seconds between two server passes over the live enemies, only changed values are sent
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Replication", meta = (EditCondition = "bReplicateAgentStates", ClampMin = "0.01", Units = "s"))
+    float ReplicationUpdateInterval = 0.1f;
+
+    // Fired on clients when the state or health of an enemy relevant to the local player arrives or changes
+    UPROPERTY(BlueprintAssignable, Category = "Spawn|Replication")
+    FOnAgentStateReplicated OnAgentStateReplicated;
+
+    // Fired on clients when an enemy died, was despawned or stopped being relevant to the local player
+    UPROPERTY(BlueprintAssignable, Category = "Spawn|Replication")
+    FOnAgentStateRemoved OnAgentStateRemoved;
+
+    // Project EnemiesToSpawn onto the navmesh and the ground once at BeginPlay, spawning starts when the results are in
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Validation")
+    bool bValidateSpawnPoints = true;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Validation", meta = (EditCondition = "bValidateSpawnPoints"))
+    bool bProjectSpawnPointsToNavMesh = true;
+
+    // Search box around each point for the navmesh projection
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Validation", meta = (EditCondition = "bValidateSpawnPoints && bProjectSpawnPointsToNavMesh"))
+    FVector NavProjectionExtent = FVector(100.0f, 100.0f, 250.0f);
+
+    // How far below a point the character's capsule is swept to find the ground
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Validation", meta = (EditCondition = "bValidateSpawnPoints", ClampMin = "0", Units = "cm"))
+    float SpawnPointTraceDistance = 1000.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Validation", meta = (EditCondition = "bValidateSpawnPoints"))
+    TEnumAsByte<ECollisionChannel> SpawnPointTraceChannel = ECC_Pawn;
+
+    // Stream archetype assets in asynchronously before spawning them
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawn|Preload")
+    bool bPreloadArchetypes = true;
+
+    // Fired when all the assets of an archetype are resident
+    UPROPERTY(BlueprintAssignable, Category = "Spawn|Preload")
+    FOnArchetypeLoaded OnArchetypeLoaded;
+
+    // Fired once RestoreSnapshot has spawned the snapshot's enemies
+    UPROPERTY(BlueprintAssignable, Category = "Spawner|Snapshot")
+    FOnSnapshotRestored OnSnapshotRestored;
+
+    // Fired every frame the queue made progress
+    UPROPERTY(BlueprintAssignable, Category = "Spawn|Queue")
+    FOnSpawnQueueProgress OnSpawnQueueProgress;
+
+    // Fired once the queue has been fully drained
+    UPROPERTY(BlueprintAssignable, Category = "Spawn|Queue")
+    FOnSpawnQueueCompleted OnSpawnQueueCompleted;
+
 #if WITH_EDITORONLY_DATA
     // Root component for editor visualization
     UPROPERTY(EditAnywhere, Category = "Spawner")
@@ -96,6 +461,8 @@ protected:
     // To add mapping context
     virtual void BeginPlay();
 
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
     // Property to store the default skeletal mesh for enemies
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI")
     USkeletalMesh* DefaultSkeletalMesh;
@@ -106,7 +473,80 @@ protected:
 
     // Property to store the default animation blueprint for enemies
     UPROPERTY(BlueprintReadOnly, Category = "AI")
-    TArray<ACharacter*> SpawnedEnemies;
+    TArray<TObjectPtr<ACharacter>> SpawnedEnemies;
+
+    // Archetype and cached components of each live or dormant character
+    UPROPERTY(Transient)
+    TMap<TObjectPtr<ACharacter>, FSpawnedEnemyRecord> EnemyRecords;
+
+    // One pool of dormant characters per data asset
+    UPROPERTY(Transient)
+    TMap<TObjectPtr<UCharacterDataAsset>, FEnemyPool> EnemyPools;
+
+    // Pending spawns, the next one to process is at the end
+    UPROPERTY(Transient)
+    TArray<FPendingEnemySpawn> SpawnQueue;
+
+    // Async load state per archetype
+    UPROPERTY(Transient)
+    TMap<TObjectPtr<UCharacterDataAsset>, FArchetypePreload> ArchetypePreloads;
+
+    // Perception components configured at spawn, registered with the perception system in one go
+    UPROPERTY(Transient)
+    TArray<TObjectPtr<UAIPerceptionComponent>> PendingPerceptionRegistrations;
+
+    // Senses of every listener this spawner configured, the only ones a reactivated enemy registers as a source for
+    UPROPERTY(Transient)
+    TSet<TSubclassOf<UAISense>> ListenerSenses;
+
+    // Dead enemies waiting to be recycled, a min-heap on RecycleTime
+    UPROPERTY(Transient)
+    TArray<FEnemyCorpse> Corpses;
+
+    // Proximity streaming grid, empty unless bUseProximityStreaming
+    UPROPERTY(Transient)
+    TArray<FEnemyStreamingCell> StreamingCells;
+
+    // One entry per EnemiesToSpawn entry while streaming
+    UPROPERTY(Transient)
+    TArray<FStreamedEnemyState> StreamedEnemies;
+
+    FTimerHandle StreamingTimerHandle;
+
+    // State and health of every live enemy on the server, filtered per player into AgentStateReplicators
+    UPROPERTY(Transient)
+    FAIAgentStateArray AgentStates;
+
+    // Server side, one per remote player controller
+    UPROPERTY(Transient)
+    TArray<TObjectPtr<AAIAgentStateReplicator>> AgentStateReplicators;
+
+    // Client side, the replicator of the local player
+    TWeakObjectPtr<AAIAgentStateReplicator> LocalAgentStateReplicator;
+
+    FTimerHandle ReplicationTimerHandle;
+
+    int32 NumSpawnsWaitingForLoad = 0;
+    int32 NumPendingSpawnPointSweeps = 0;
+    bool bSpawnPointValidationPending = false;
+    int32 NumRejectedSpawnPoints = 0;
+    int32 SpawnQueueProcessed = 0;
+    int32 SpawnQueueSequence = 0;
+    bool bSpawnQueueNeedsSort = false;
+
+    // Set while a queue slice or a snapshot restore spawns, the batch registers its perception at the end
+    bool bInSpawnBatch = false;
+
+    // Snapshot read by RestoreSnapshot, applied once its data assets are loaded and their archetypes resident
+    TSharedPtr<FEnemySpawnerSnapshot> PendingSnapshot;
+    TSharedPtr<FStreamableHandle> PendingSnapshotHandle;
+
+    // One entry per snapshot archetype path, null when the path did not load
+    UPROPERTY(Transient)
+    TArray<TObjectPtr<UCharacterDataAsset>> PendingSnapshotArchetypes;
+
+    // Player locations the queue priorities were last computed from
+    TArray<FVector, TInlineAllocator<4>> ScoredPlayerLocations;
 
 protected:
 
@@ -119,10 +559,146 @@ private:
     UFUNCTION(BlueprintCallable, Category = "AI|Perception")
     void AssignAIPerceptionConfig(ACharacter* SpawnedCharacter, const UCharacterDataAsset* CharacterDataAsset, AAIController* AICharacterController);
 
-    UFUNCTION(BlueprintCallable, Category = "AI|Perception")
-    void OnPerceptionUpdated(const TArray<AActor*>& UpdatedActors);
+    // Registers the perception components created since the last flush
+    void FlushPerceptionRegistrations();
+
+    // Called by the enemy's perception relay, only the enemy that perceived the stimulus reacts
+    void HandleTargetPerceptionUpdated(ACharacter* Enemy, AActor* Actor, const FAIStimulus& Stimulus);
+
+    // Fills the cached component pointers of a fresh enemy once its components were added and its tree started
+    void CacheEnemyRecord(ACharacter* Enemy, FSpawnedEnemyRecord& Record);
+
+    // Makes a live enemy reachable by alerts from its neighbours and squad, and puts it under AI LOD
+    void RegisterAlertAgent(ACharacter* Enemy, const FSpawnedEnemyRecord& Record);
+
+    UPROPERTY(Transient)
+    TObjectPtr<UAlertPropagationSubsystem> AlertSubsystem;
+
+    UPROPERTY(Transient)
+    TObjectPtr<UDamageQueueSubsystem> DamageQueue;
+
+    UPROPERTY(Transient)
+    TObjectPtr<UAILODSubsystem> LODSubsystem;
+
+    UPROPERTY(Transient)
+    TObjectPtr<UAICrowdSubsystem> CrowdSubsystem;
+
+    UPROPERTY(Transient)
+    TObjectPtr<UBlackboardWriteSubsystem> BlackboardWriter;
+
+    // Goes through BlackboardWriter so writes the key already holds never reach the blackboard
+    void WriteBlackboardState(UBlackboardComponent* Blackboard, FBlackboard::FKey AIStateKey, uint8 State);
+
+    FDelegateHandle AgentsDiedHandle;
+
+    // Batched deaths of the damage queue, forwarded to OnEnemyDeath for the enemies of this spawner
+    void HandleAgentsDied(const TArray<AActor*>& DeadActors);
+
+    // Refreshes AgentStates from the live enemies and hands each remote player the relevant ones, runs on a timer on servers
+    void UpdateReplicatedAgentStates();
+
+    // Spawns a replicator for every remote player controller without one and destroys the ones of players that left
+    void UpdateAgentStateReplicators();
+
+    // Drops a stopped or destroyed enemy from AgentStates and from every player's replicator
+    void RemoveReplicatedAgent(const ACharacter* Enemy);
+
+    friend class UEnemyPerceptionRelay;
+    friend class FAIBenchmark;
 
     UFUNCTION()
     void AddComponentsToCharacter(const UCharacterDataAsset* CharacterDataAsset, ACharacter* SpawnedEnemy);
 
+    // Spawns a new character with its controller and runs the full per-archetype setup
+    ACharacter* CreateEnemy(UCharacterDataAsset* CharacterDataAsset, const FTransform& SpawnTransform);
+
+    // Shows the character and restarts its brain, perception and movement
+    void ActivateEnemy(ACharacter* Enemy, UCharacterDataAsset* CharacterDataAsset, const FTransform& SpawnTransform);
+
+    // Stops the brain, perception, movement and tick but leaves the character visible, e.g. as a corpse
+    void StopEnemy(ACharacter* Enemy);
+
+    // Stops the character and hides it, ready to sit in the pool
+    void DeactivateEnemy(ACharacter* Enemy);
+
+    // Pools or destroys a corpse whose lifetime ran out
+    void RecycleCorpse(ACharacter* Enemy);
+
+    // Destroys a character the spawner no longer tracks as live, along with its controller
+    void DestroyEnemy(ACharacter* Enemy);
+
+    // Takes a live enemy out of the world, back to the pool or destroyed without pooling
+    void DespawnEnemy(ACharacter* Enemy);
+
+    // Health (negative without a damageable component) and state of a live enemy
+    void CaptureEnemyState(const FSpawnedEnemyRecord& Record, float& OutHealth, EAICharacterState& OutState) const;
+
+    // Overrides the archetype defaults a fresh spawn starts with, negative health and None leave them alone
+    void RestoreEnemyState(FSpawnedEnemyRecord& Record, float Health, EAICharacterState State);
+
+    // Hands EnemiesToSpawn to the crowd, the streaming cells or the spawn queue, and queues the pool prewarming
+    void StartSpawning();
+
+    // Validates the spawn points once every archetype of EnemiesToSpawn is resident, then starts spawning if no sweep is out
+    void TryValidateSpawnPoints();
+
+    // Projects EnemiesToSpawn onto the navmesh in one batch and issues one async capsule sweep per point
+    void ValidateSpawnPoints();
+
+    // Snaps the entry to the ground the sweep found, starts spawning once the last sweep is back
+    void HandleSpawnPointSweep(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+    // Buckets EnemiesToSpawn into StreamingCellSize cells
+    void BuildStreamingCells();
+
+    // Player view points plus the world partition streaming sources
+    void GatherStreamingSources(TArray<FVector2D, TInlineAllocator<8>>& OutSources) const;
+
+    // Queues the entries of the cell that are neither alive nor dead
+    void ActivateStreamingCell(int32 CellIndex);
+
+    // Saves health and state of the cell's enemies and sends them back to the pool
+    void DeactivateStreamingCell(int32 CellIndex);
+
+    // Spawns a queued streaming entry and restores what was saved when it was despawned
+    void SpawnStreamedEnemy(int32 EntryIndex);
+
+    // Recycles expired corpses, at most MaxCorpseRecyclesPerFrame
+    void ProcessCorpses();
+
+    // Ticks only while the spawn queue or the corpses have work
+    void UpdateTickEnabled();
+
+    // Drops a character destroyed by anyone else from the roster
+    UFUNCTION()
+    void HandleEnemyDestroyed(AActor* DestroyedActor);
+
+    // Creates one character and sends it straight to its archetype pool
+    ACharacter* CreateDormantEnemy(UCharacterDataAsset* CharacterDataAsset);
+
+    // Adds to the spawn queue, or parks the entry until its archetype is resident
+    void EnqueuePendingSpawn(const FPendingEnemySpawn& Pending);
+
+    void HandleArchetypePreloaded(UCharacterDataAsset* CharacterDataAsset);
+
+    // Preloads the archetypes of the pending snapshot once its data assets are in memory
+    void HandleSnapshotDataAssetsLoaded(TWeakPtr<FEnemySpawnerSnapshot> Snapshot);
+
+    // Applies the pending snapshot when every one of its archetypes is resident
+    void TryApplyPendingSnapshot();
+
+    void ApplySnapshot(const FEnemySpawnerSnapshot& Snapshot, const TArray<UCharacterDataAsset*>& Archetypes);
+
+    // Processes queued spawns until the time budget runs out
+    void ProcessSpawnQueue(double BudgetSeconds);
+
+    // Refreshes priorities from the player locations when a player moved past SpawnQueueRescoreDistance or entries were added
+    void RescoreSpawnQueue();
+
+    // Orders the queue by priority
+    void SortSpawnQueue();
+
+    UFUNCTION()
+    void OnEnemyDeath(AActor* DeadActor);
+
 };
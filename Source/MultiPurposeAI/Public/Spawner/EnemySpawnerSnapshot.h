@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Layout versions of FEnemySpawnerSnapshot, add new ones before LatestPlusOne
+ */
+enum class EEnemySnapshotVersion : uint32
+{
+    Initial = 1,
+
+    LatestPlusOne,
+    Latest = LatestPlusOne - 1
+};
+
+/**
+ * Runtime state of every live enemy of a spawner, stored as flat arrays so saving and loading is a handful of bulk copies
+ * Only plain values are stored, the characters are spawned again through the spawner when the snapshot is restored
+ */
+struct MULTIPURPOSEAI_API FEnemySpawnerSnapshot
+{
+    // "MPAS", rejects blobs that are not snapshots at all
+    static constexpr uint32 Magic = 0x5341504D;
+
+    // Data asset paths, agents refer to them by index
+    TArray<FString> Archetypes;
+
+    // One entry per agent
+    TArray<uint16> ArchetypeIndices;
+    TArray<FVector3f> Locations;
+    TArray<float> Yaws;
+    TArray<int32> SquadIds;
+
+    // Negative for agents without a damageable component
+    TArray<float> Health;
+
+    // EAICharacterState of the state manager, and of the blackboard AIState key
+    TArray<uint8> States;
+    TArray<uint8> BlackboardStates;
+
+    // EnemiesToSpawn entry the agent streams in for, INDEX_NONE when it is not streamed
+    TArray<int32> StreamingEntries;
+
+    // Proximity streaming state, one entry per EnemiesToSpawn entry and per cell, empty when streaming is off
+    TArray<float> StreamedHealth;
+    TArray<uint8> StreamedStates;
+    TArray<uint8> StreamedDead;
+    TArray<uint8> ActiveCells;
+
+    int32 Num() const { return ArchetypeIndices.Num(); }
+
+    void Reserve(int32 NumAgents);
+
+    // Reads or writes the whole snapshot, returns false when loading data of another format, a newer version, inconsistent
+    // sizes or states outside EAICharacterState
+    bool Serialize(FArchive& Ar);
+};
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MassEntityTypes.h"
+#include "AICrowdSubsystem.generated.h"
+
+class ACharacter;
+class AEnemySpawner;
+class UCharacterDataAsset;
+class UAICrowdSignificanceProcessor;
+struct FEnemySpawnData;
+struct FMassEntityManager;
+
+/**
+ * Keeps far away enemies as Mass entities (transform, state, health) and promotes them to full characters through their
+ * spawner when a player comes close, demoting them back once every player is far enough again.
+ */
+UCLASS(config = Game)
+class MULTIPURPOSEAI_API UAICrowdSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+    // Creates one entity per entry, in one batch per archetype
+    void SpawnEntities(AEnemySpawner* Spawner, TConstArrayView<FEnemySpawnData> SpawnEntries);
+
+    // Destroys every entity of the spawner, its promoted characters are left to the spawner
+    void DestroyEntities(const AEnemySpawner* Spawner);
+
+    // Called by the spawner when a promoted character died, the entity goes with it
+    void HandlePromotedEnemyDied(ACharacter* Enemy);
+
+    UFUNCTION(BlueprintPure, Category = "AI|Crowd")
+    int32 GetNumEntities() const { return NumEntities; }
+
+    UFUNCTION(BlueprintPure, Category = "AI|Crowd")
+    int32 GetNumPromoted() const { return PromotedEntities.Num(); }
+
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+protected:
+
+    // Entities closer than this to a player become characters
+    UPROPERTY(Config)
+    float PromoteRadius = 3000.0f;
+
+    // Characters farther than this from every player go back to being entities, keep it above PromoteRadius
+    UPROPERTY(Config)
+    float DemoteRadius = 4000.0f;
+
+    // Spawning a character is expensive, the rest waits for the next frames
+    UPROPERTY(Config)
+    int32 MaxPromotionsPerTick = 8;
+
+    UPROPERTY(Config)
+    int32 MaxDemotionsPerTick = 16;
+
+private:
+
+    FMassEntityManager* GetEntityManager() const;
+
+    void PromoteEntity(FMassEntityManager& EntityManager, FMassEntityHandle Entity);
+
+    void DemoteEntity(FMassEntityManager& EntityManager, FMassEntityHandle Entity);
+
+    // Copies the transforms of the promoted characters back so significance follows them
+    void SyncPromotedTransforms(FMassEntityManager& EntityManager);
+
+    void GatherPlayerLocations(TArray<FVector>& OutLocations) const;
+
+    UPROPERTY(Transient)
+    TObjectPtr<UAICrowdSignificanceProcessor> SignificanceProcessor;
+
+    FMassArchetypeHandle EntityArchetype;
+
+    TMap<TWeakObjectPtr<const AActor>, FMassEntityHandle> PromotedEntities;
+
+    int32 NumEntities = 0;
+};
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AILODSubsystem.generated.h"
+
+class ACharacter;
+class AAIController;
+class UCharacterDataAsset;
+
+/**
+ * Picks the LOD tier of every registered enemy from its distance to the nearest player.
+ * Agents are re-evaluated a slice at a time over flat arrays, and components are only touched when the tier changes.
+ */
+UCLASS(config = Game)
+class MULTIPURPOSEAI_API UAILODSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+    // Does nothing when the data asset has no LOD tiers, the agent then always runs at full cost
+    void RegisterAgent(ACharacter* Agent, AAIController* Controller, const UCharacterDataAsset* DataAsset);
+
+    // Restores full-rate ticking on whatever the agent still has and resumes a brain the dormant tier paused
+    void UnregisterAgent(ACharacter* Agent);
+
+    // INDEX_NONE when the agent is not registered
+    UFUNCTION(BlueprintPure, Category = "AI|LOD")
+    int32 GetAgentTier(const ACharacter* Agent) const;
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+protected:
+
+    // Agents re-evaluated per frame, the pass wraps around so every agent is visited every Num/AgentsPerTick frames
+    UPROPERTY(Config)
+    int32 AgentsPerTick = 256;
+
+    // Extra distance an agent has to move past its tier before it drops to a farther one, avoids flickering at the border
+    UPROPERTY(Config)
+    float TierHysteresis = 200.0f;
+
+private:
+
+    void GatherPlayerLocations();
+
+    int32 ComputeTier(int32 Index) const;
+
+    void ApplyTier(int32 Index, int32 Tier);
+
+    void RemoveAgentAt(int32 Index);
+
+    // Agent data, one entry per registered agent in every array
+    TArray<TWeakObjectPtr<ACharacter>> Agents;
+    TArray<TWeakObjectPtr<AAIController>> Controllers;
+    TArray<TObjectPtr<const UCharacterDataAsset>> DataAssets;
+    TArray<FVector> Locations;
+    TArray<int32> Tiers;
+
+    TMap<TWeakObjectPtr<AActor>, int32> AgentIndices;
+
+    TArray<FVector> PlayerLocations;
+
+    // Next agent of the round-robin pass
+    int32 NextAgentIndex = 0;
+};
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Enums.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BehaviorTree/BehaviorTreeTypes.h"
+#include "AIStateSubsystem.generated.h"
+
+class UBlackboardComponent;
+class UBlackboardWriteSubsystem;
+
+/**
+ * Holds the EAICharacterState of every agent in the world in flat arrays.
+ * UStateManagerComponent only keeps a handle into it, so bulk queries and the blackboard mirror
+ * run over contiguous data instead of chasing components actor by actor.
+ */
+UCLASS()
+class MULTIPURPOSEAI_API UAIStateSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+    // Returns a handle that stays valid until UnregisterAgent
+    int32 RegisterAgent(AActor* Agent, EAICharacterState InitialState);
+
+    void UnregisterAgent(int32 Handle);
+
+    bool IsValidHandle(int32 Handle) const;
+
+    EAICharacterState GetState(int32 Handle) const;
+
+    EAICharacterState GetPreviousState(int32 Handle) const;
+
+    // Seconds since the agent entered its current state
+    float GetTimeInState(int32 Handle) const;
+
+    // Returns false when the agent already was in NewState
+    bool SetState(int32 Handle, EAICharacterState NewState);
+
+    // Mirrors the agent's state into the given enum key once per frame, whenever it changed
+    void SetBlackboardMirror(int32 Handle, UBlackboardComponent* Blackboard, FBlackboard::FKey AIStateKey);
+
+    UFUNCTION(BlueprintPure, Category = "AI|State")
+    int32 CountAgentsInState(EAICharacterState State) const;
+
+    UFUNCTION(BlueprintCallable, Category = "AI|State")
+    void GetAgentsInState(EAICharacterState State, TArray<AActor*>& OutAgents) const;
+
+    // Writes every pending state change to its blackboard, called from Tick
+    void FlushBlackboardMirror();
+
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+private:
+
+    double GetWorldTime() const;
+
+    // Drops mirror writes the key already holds, e.g. a state that changed and came back within the frame
+    UPROPERTY(Transient)
+    TObjectPtr<UBlackboardWriteSubsystem> BlackboardWriter;
+
+    // One slot per agent in every array, freed slots are reused through FreeHandles
+    TArray<EAICharacterState> States;
+    TArray<EAICharacterState> PreviousStates;
+    TArray<double> StateEnterTimes;
+    TArray<TWeakObjectPtr<AActor>> Agents;
+    TArray<TWeakObjectPtr<UBlackboardComponent>> Blackboards;
+    TArray<FBlackboard::FKey> AIStateKeys;
+    TBitArray<> AllocatedSlots;
+
+    TArray<int32> FreeHandles;
+
+    // Number of allocated agents per state, indexed by the enum value
+    TArray<int32> StateCounts;
+
+    // Agents whose blackboard is behind their state
+    TArray<int32> DirtyMirrors;
+    TBitArray<> DirtyMirrorFlags;
+};
@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Enums.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "AlertPropagationSubsystem.generated.h"
+
+class UStateManagerComponent;
+
+/**
+ * Spreads "one sees you, nearby allies react" alerts.
+ * Agents are bucketed in a uniform grid and every alert raised during a frame is resolved in a single pass,
+ * so each agent gets at most one state change per frame no matter how many alerts reached it.
+ */
+UCLASS(config = Game)
+class MULTIPURPOSEAI_API UAlertPropagationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+    // Adds an agent that can receive alerts, AlertState is what it switches to when an alert doesn't carry its own state.
+    // Squads are scoped to SquadOwner, e.g. the spawner, so equal ids of different owners are different squads
+    void RegisterAgent(AActor* Agent, UStateManagerComponent* StateManager, EAICharacterState AlertState, const UObject* SquadOwner, int32 SquadId);
+
+    void UnregisterAgent(AActor* Agent);
+
+    // Alerts every agent within Radius of Source and every agent of Source's squad at the end of the frame
+    UFUNCTION(BlueprintCallable, Category = "AI|Alert")
+    void RaiseAlert(AActor* Source, float Radius, EAICharacterState State = EAICharacterState::None);
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+protected:
+
+    // Edge length of the grid cells, roughly the most common alert radius works best
+    UPROPERTY(Config)
+    float GridCellSize = 1000.0f;
+
+private:
+
+    // Squad owner and id, the id is INDEX_NONE for agents without a squad
+    using FSquadKey = TPair<FObjectKey, int32>;
+
+    struct FPendingAlert
+    {
+        FVector Origin;
+        float Radius;
+        FSquadKey Squad;
+        EAICharacterState State;
+    };
+
+    FIntVector GetCell(const FVector& Location) const;
+
+    void AddSquadMember(const FSquadKey& Squad, int32 Index);
+    void RemoveSquadMember(const FSquadKey& Squad, int32 Index);
+
+    // Marks every agent within Radius of Origin
+    void AlertRadius(const FPendingAlert& Alert);
+
+    void RemoveAgentAt(int32 Index);
+
+    void RebuildGrid();
+
+    void ApplyAlertState(int32 AgentIndex, EAICharacterState State);
+
+    // Agent data, one entry per registered agent in every array
+    TArray<TWeakObjectPtr<AActor>> Agents;
+    TArray<TWeakObjectPtr<UStateManagerComponent>> StateManagers;
+    TArray<EAICharacterState> AlertStates;
+    TArray<FSquadKey> Squads;
+    TArray<FVector> Locations;
+
+    // Weak keys keep their hash after the actor is gone, so stale agents can still be unregistered
+    TMap<TWeakObjectPtr<AActor>, int32> AgentIndices;
+
+    // Agent indices per squad, kept up to date on registration so a squad alert only touches its members
+    TMap<FSquadKey, TArray<int32>> SquadMembers;
+
+    // Only rebuilt on frames that have alerts to resolve
+    TMap<FIntVector, TArray<int32>> Grid;
+
+    TArray<FPendingAlert> PendingAlerts;
+
+    // Per agent state to apply this frame, None when the agent was not alerted
+    TArray<EAICharacterState> PendingStates;
+};
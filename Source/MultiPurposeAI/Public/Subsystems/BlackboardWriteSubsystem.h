@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BehaviorTree/BehaviorTreeTypes.h"
+#include "BlackboardWriteSubsystem.generated.h"
+
+class UBlackboardComponent;
+
+/**
+ * Sits between the AI code and UBlackboardComponent so key writes only reach the blackboard when they change something.
+ * Writes are queued per blackboard, a later write to the same key replaces the earlier one, and values the key
+ * already holds are dropped. Each blackboard then gets its writes in one go with observer notifications paused,
+ * so decorators and aborts see every key at its final value and run once per flush instead of once per write.
+ */
+UCLASS()
+class MULTIPURPOSEAI_API UBlackboardWriteSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+    // Queued until the next flush, returns false when the write was dropped
+    bool SetEnum(UBlackboardComponent* Blackboard, FBlackboard::FKey KeyID, uint8 Value);
+
+    bool SetObject(UBlackboardComponent* Blackboard, FBlackboard::FKey KeyID, UObject* Value);
+
+    // Applies what is queued for one blackboard right away, e.g. so a freshly spawned tree starts on its final keys
+    void FlushBlackboard(UBlackboardComponent* Blackboard);
+
+    // Applies every queued write, called from Tick
+    void Flush();
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+private:
+
+    enum class EWriteType : uint8
+    {
+        Enum,
+        Object
+    };
+
+    struct FPendingWrite
+    {
+        FBlackboard::FKey KeyID = FBlackboard::InvalidKey;
+        EWriteType Type = EWriteType::Enum;
+        uint8 EnumValue = 0;
+        TWeakObjectPtr<UObject> ObjectValue;
+    };
+
+    struct FWriteBatch
+    {
+        TWeakObjectPtr<UBlackboardComponent> Blackboard;
+
+        // At most one write per key, in the order the keys were first written
+        TArray<FPendingWrite, TInlineAllocator<4>> Writes;
+    };
+
+    // Replaces the write already queued for the key, or queues it when the key does not hold the value yet
+    bool QueueWrite(UBlackboardComponent& Blackboard, const FPendingWrite& Write);
+
+    static bool HoldsValue(const UBlackboardComponent& Blackboard, const FPendingWrite& Write);
+
+    void ApplyBatch(FWriteBatch& Batch);
+
+    // One batch per blackboard with writes pending
+    TArray<FWriteBatch> Batches;
+    TMap<TWeakObjectPtr<UBlackboardComponent>, int32> BatchIndices;
+
+    // Batches being applied by Flush, writes queued by observers meanwhile wait for the next flush
+    TArray<FWriteBatch> FlushingBatches;
+};
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DamageQueueSubsystem.generated.h"
+
+class UDamageableComponent;
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnAgentsDied, const TArray<AActor*>& /*DeadActors*/);
+
+/**
+ * Collects the damage dealt during the frame and resolves it in one pass over flat health arrays.
+ * Hits on the same agent are summed, and every death of the frame is reported in a single OnAgentsDied broadcast.
+ */
+UCLASS(config=Game)
+class MULTIPURPOSEAI_API UDamageQueueSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+    // Returns a handle that stays valid until UnregisterTarget
+    int32 RegisterTarget(UDamageableComponent* Component, float MaxHealth, float CurrentHealth);
+
+    void UnregisterTarget(int32 Handle);
+
+    bool IsValidHandle(int32 Handle) const;
+
+    float GetCurrentHealth(int32 Handle) const;
+
+    float GetMaxHealth(int32 Handle) const;
+
+    void SetMaxHealth(int32 Handle, float MaxHealth);
+
+    // Also drops the damage still pending for the target, e.g. when a pooled enemy is revived
+    void SetCurrentHealth(int32 Handle, float Health);
+
+    // Applied on the next ProcessPendingDamage, dead targets ignore it
+    void QueueDamage(int32 Handle, float Damage);
+
+    // Same as QueueDamage for every target, e.g. the actors hit by an area ability
+    UFUNCTION(BlueprintCallable, Category = "Damage")
+    void QueueAreaDamage(const TArray<AActor*>& Targets, float Damage);
+
+    // Resolves every pending hit and broadcasts the deaths, called from Tick
+    void ProcessPendingDamage();
+
+    // Every target that reached 0 health this frame, after the health of all of them is final
+    FOnAgentsDied OnAgentsDied;
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+protected:
+
+    // Dirty targets resolved with ParallelFor from this count on
+    UPROPERTY(Config)
+    int32 ParallelThreshold = 512;
+
+private:
+
+    // One slot per target in every array, freed slots are reused through FreeHandles
+    TArray<float> CurrentHealth;
+    TArray<float> MaxHealth;
+    TArray<float> PendingDamage;
+    TArray<TWeakObjectPtr<UDamageableComponent>> Components;
+    TBitArray<> AllocatedSlots;
+
+    TArray<int32> FreeHandles;
+
+    TMap<TWeakObjectPtr<AActor>, int32> TargetHandles;
+
+    // Targets with damage pending this frame
+    TArray<int32> DirtyHandles;
+    TBitArray<> DirtyFlags;
+
+    // Scratch of ProcessPendingDamage, one byte per dirty target so the parallel pass can write it
+    TArray<uint8> DiedThisFrame;
+    TArray<AActor*> DeadActors;
+
+    // Weak, OnAgentsDied listeners may destroy the actors before their components handle the death
+    TArray<TWeakObjectPtr<UDamageableComponent>> DeadComponents;
+};